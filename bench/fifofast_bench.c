@@ -0,0 +1,441 @@
+/*
+ * fifofast_bench.c
+ *
+ * Created: 17.10.2026 14:20:06
+ *
+ * Description:
+ * Single-threaded micro-benchmark of the function-like macros and the inline functions of
+ * pointable fifos. Each operation is measured for element sizes of 1, 2, 4, 8 and 32 bytes (like
+ * 'frame_u' of the demo) and depths from 4 to 2^20 (pointable fifos: up to
+ * FIFOFAST_MAX_DEPTH_POINTABLE). Results are reported in ns/op and elements/s.
+ *
+ * The macros are measured with 2^n fifos (variant "fifo") and with fifos declared by
+ * _fff_declare_exact(...) with 3/4 of that depth (variant "exact"), which wrap their indices with a
+ * compare instead of a mask.
+ *
+ * Each round accesses every element of the fifo once, so large depths include the cost of cache
+ * and TLB misses. Between two rounds only the level is changed (e.g. a full fifo from which all
+ * elements have been read is full again), so no time is spent on refilling.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -o fifofast_bench bench/fifofast_bench.c
+ *   ./fifofast_bench > before.csv
+ *   ./fifofast_bench -j -f _fff_write -d 12 > after.json
+ *
+ * Options:
+ *   -j			print JSON instead of CSV
+ *   -t ms		minimum duration of a single run, default BENCH_MIN_TIME_MS
+ *   -d exp		largest depth is 2^exp, default 20
+ *   -f text	only run operations containing 'text', e.g. "multiple" or "fff_"
+ */
+
+#define _GNU_SOURCE			// required for sched_setaffinity() in fifofast_bench.h
+
+#include "../fifofast.h"
+#include "fifofast_bench.h"
+
+
+//////////////////////////////////////////////////////////////////////////
+// Benchmark Config
+//////////////////////////////////////////////////////////////////////////
+
+// elements per call of the *_multiple operations; smaller fifos use their depth instead
+#define BENCH_BATCH						32
+
+// element of 32 bytes, like 'frame_u' of the demo
+typedef struct
+{
+	uint8_t raw[32];
+} bench_frame_t;
+
+
+//////////////////////////////////////////////////////////////////////////
+// Benchmark Cases
+//////////////////////////////////////////////////////////////////////////
+
+// source and destination of the written/ read elements of each type
+#define BENCH_TYPE(_type)												\
+static _type bench_src_##_type[BENCH_BATCH];							\
+static _type bench_dst_##_type[BENCH_BATCH];
+
+BENCH_TYPE(uint8_t)
+BENCH_TYPE(uint16_t)
+BENCH_TYPE(uint32_t)
+BENCH_TYPE(uint64_t)
+BENCH_TYPE(bench_frame_t)
+
+#define BENCH_FIFO(_type, _exp)			bench_fifo_##_type##_##_exp
+#define BENCH_FN(_type, _exp, _name)	bench_##_name##_##_type##_##_exp
+
+// declares all function-like macro benchmarks of the fifo BENCH_FIFO(_tag, _exp), which holds
+// '_depth' elements of '_type'. The results are reported with the variant '_variant'.
+#define BENCH_OPS(_type, _tag, _exp, _depth, _variant)					\
+static void BENCH_FN(_tag, _exp, write)(uint64_t rounds)				\
+{																		\
+	BENCH_FIFO(_tag, _exp).level = 0;									\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (_depth); k++)							\
+			_fff_write(BENCH_FIFO(_tag, _exp), bench_src_##_type[k % BENCH_BATCH]);	\
+		BENCH_FIFO(_tag, _exp).level = 0;								\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_tag, _exp, read)(uint64_t rounds)					\
+{																		\
+	BENCH_FIFO(_tag, _exp).level = (_depth);							\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (_depth); k++)							\
+		{																\
+			_type _x = _fff_read(BENCH_FIFO(_tag, _exp));				\
+			BENCH_USE(_x);												\
+		}																\
+		BENCH_FIFO(_tag, _exp).level = (_depth);						\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_tag, _exp, peek)(uint64_t rounds)					\
+{																		\
+	BENCH_FIFO(_tag, _exp).level = (_depth);							\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (_depth); k++)							\
+		{																\
+			_type _x = _fff_peek(BENCH_FIFO(_tag, _exp), k);			\
+			BENCH_USE(_x);												\
+		}																\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_tag, _exp, add)(uint64_t rounds)					\
+{																		\
+	BENCH_FIFO(_tag, _exp).level = 0;									\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (_depth); k++)							\
+		{																\
+			_type *_p = _fff_add(BENCH_FIFO(_tag, _exp));				\
+			if (_p != NULL)												\
+				*_p = bench_src_##_type[k % BENCH_BATCH];				\
+		}																\
+		BENCH_FIFO(_tag, _exp).level = 0;								\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_tag, _exp, remove)(uint64_t rounds)				\
+{																		\
+	BENCH_FIFO(_tag, _exp).level = (_depth);							\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (_depth); k++)							\
+			_fff_remove(BENCH_FIFO(_tag, _exp), 1);						\
+		BENCH_FIFO(_tag, _exp).level = (_depth);						\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_tag, _exp, write_lite)(uint64_t rounds)			\
+{																		\
+	BENCH_FIFO(_tag, _exp).level = 0;									\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (_depth); k++)							\
+			_fff_write_lite(BENCH_FIFO(_tag, _exp), bench_src_##_type[k % BENCH_BATCH]);	\
+		BENCH_FIFO(_tag, _exp).level = 0;								\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_tag, _exp, read_lite)(uint64_t rounds)			\
+{																		\
+	BENCH_FIFO(_tag, _exp).level = (_depth);							\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (_depth); k++)							\
+		{																\
+			_type _x = _fff_read_lite(BENCH_FIFO(_tag, _exp));			\
+			BENCH_USE(_x);												\
+		}																\
+		BENCH_FIFO(_tag, _exp).level = (_depth);						\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_tag, _exp, remove_lite)(uint64_t rounds)			\
+{																		\
+	BENCH_FIFO(_tag, _exp).level = (_depth);							\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (_depth); k++)							\
+			_fff_remove_lite(BENCH_FIFO(_tag, _exp), 1);				\
+		BENCH_FIFO(_tag, _exp).level = (_depth);						\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_tag, _exp, write_multiple)(uint64_t rounds)		\
+{																		\
+	const size_t _b = _min((_depth), BENCH_BATCH);						\
+	BENCH_FIFO(_tag, _exp).level = 0;									\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (_depth); k += _b)						\
+			_fff_write_multiple(BENCH_FIFO(_tag, _exp), bench_src_##_type, _b);	\
+		BENCH_FIFO(_tag, _exp).level = 0;								\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_tag, _exp, read_multiple)(uint64_t rounds)		\
+{																		\
+	const size_t _b = _min((_depth), BENCH_BATCH);						\
+	BENCH_FIFO(_tag, _exp).level = (_depth);							\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (_depth); k += _b)						\
+		{																\
+			_fff_read_multiple(BENCH_FIFO(_tag, _exp), bench_dst_##_type, _b);	\
+			BENCH_USE(bench_dst_##_type);								\
+		}																\
+		BENCH_FIFO(_tag, _exp).level = (_depth);						\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+/* worst case: full fifo, the first element is in the middle of the array */	\
+static void BENCH_FN(_tag, _exp, rebase)(uint64_t rounds)				\
+{																		\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		BENCH_FIFO(_tag, _exp).read	= (_depth)/2;						\
+		BENCH_FIFO(_tag, _exp).write	= (_depth)/2;					\
+		BENCH_FIFO(_tag, _exp).level	= (_depth);						\
+		_fff_rebase(BENCH_FIFO(_tag, _exp));							\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_tag, _exp, run)(void)								\
+{																		\
+	const size_t _d = (_depth);											\
+	const size_t _b = _min(_d, BENCH_BATCH);							\
+	bench_run("_fff_write", _variant, sizeof(_type), _d, 1, _d, BENCH_FN(_tag, _exp, write));	\
+	bench_run("_fff_read", _variant, sizeof(_type), _d, 1, _d, BENCH_FN(_tag, _exp, read));	\
+	bench_run("_fff_peek", _variant, sizeof(_type), _d, 1, _d, BENCH_FN(_tag, _exp, peek));	\
+	bench_run("_fff_add", _variant, sizeof(_type), _d, 1, _d, BENCH_FN(_tag, _exp, add));	\
+	bench_run("_fff_remove", _variant, sizeof(_type), _d, 1, _d, BENCH_FN(_tag, _exp, remove));	\
+	bench_run("_fff_write_lite", _variant, sizeof(_type), _d, 1, _d, BENCH_FN(_tag, _exp, write_lite));	\
+	bench_run("_fff_read_lite", _variant, sizeof(_type), _d, 1, _d, BENCH_FN(_tag, _exp, read_lite));	\
+	bench_run("_fff_remove_lite", _variant, sizeof(_type), _d, 1, _d, BENCH_FN(_tag, _exp, remove_lite));	\
+	bench_run("_fff_write_multiple", _variant, sizeof(_type), _d, _b, _d/_b, BENCH_FN(_tag, _exp, write_multiple));	\
+	bench_run("_fff_read_multiple", _variant, sizeof(_type), _d, _b, _d/_b, BENCH_FN(_tag, _exp, read_multiple));	\
+	bench_run("_fff_rebase", _variant, sizeof(_type), _d, _d, 1, BENCH_FN(_tag, _exp, rebase));	\
+}
+
+// declares a fifo of 2^_exp elements of '_type' and all function-like macro benchmarks for it
+#define BENCH_CASE(_type, _exp)											\
+static _fff_declare(_type, BENCH_FIFO(_type, _exp), (1ul<<_exp));		\
+static _fff_init(BENCH_FIFO(_type, _exp));								\
+BENCH_OPS(_type, _type, _exp, (1ul<<_exp), "fifo")
+
+// declares a fifo of exactly 3/4 * 2^_exp elements (_fff_declare_exact) and the same benchmarks,
+// so the compare-and-subtract wrap can be compared with the masked wrap of BENCH_CASE(...)
+#define BENCH_CASE_X(_type, _exp)										\
+static _fff_declare_exact(_type, BENCH_FIFO(x##_type, _exp), (3ul<<(_exp-2)));	\
+static _fff_init(BENCH_FIFO(x##_type, _exp));							\
+BENCH_OPS(_type, x##_type, _exp, (3ul<<(_exp-2)), "exact")
+
+// declares a pointable fifo of 2^_exp elements of '_type' and all inline function benchmarks for it
+#define BENCH_CASE_P(_type, _exp)										\
+static _fff_declare_p(_type, BENCH_FIFO(p##_type, _exp), (1ul<<_exp));	\
+static _fff_init_p(BENCH_FIFO(p##_type, _exp));							\
+																		\
+static void BENCH_FN(_type, _exp, p_write)(uint64_t rounds)				\
+{																		\
+	fff_proto_t *_f = (fff_proto_t*)&BENCH_FIFO(p##_type, _exp);		\
+	_f->level = 0;														\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (1ul<<_exp); k++)						\
+			fff_write(_f, &bench_src_##_type[k % BENCH_BATCH]);			\
+		_f->level = 0;													\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_type, _exp, p_peek)(uint64_t rounds)				\
+{																		\
+	fff_proto_t *_f = (fff_proto_t*)&BENCH_FIFO(p##_type, _exp);		\
+	_f->level = (1ul<<_exp);											\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (1ul<<_exp); k++)						\
+		{																\
+			_type _x = *(_type*)fff_peek_read(_f, k);					\
+			BENCH_USE(_x);												\
+		}																\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_type, _exp, p_peek_write)(uint64_t rounds)		\
+{																		\
+	fff_proto_t *_f = (fff_proto_t*)&BENCH_FIFO(p##_type, _exp);		\
+	_f->level = (1ul<<_exp);											\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (1ul<<_exp); k++)						\
+			fff_peek_write(_f, k, &bench_src_##_type[k % BENCH_BATCH]);	\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_type, _exp, p_remove)(uint64_t rounds)			\
+{																		\
+	fff_proto_t *_f = (fff_proto_t*)&BENCH_FIFO(p##_type, _exp);		\
+	_f->level = (1ul<<_exp);											\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (1ul<<_exp); k++)						\
+			fff_remove(_f, 1);											\
+		_f->level = (1ul<<_exp);										\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_type, _exp, p_write_multiple)(uint64_t rounds)	\
+{																		\
+	fff_proto_t *_f = (fff_proto_t*)&BENCH_FIFO(p##_type, _exp);		\
+	const size_t _b = _min((1ul<<_exp), BENCH_BATCH);					\
+	_f->level = 0;														\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (1ul<<_exp); k += _b)					\
+			fff_write_multiple(_f, bench_src_##_type, _b);				\
+		_f->level = 0;													\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_type, _exp, p_read_multiple)(uint64_t rounds)		\
+{																		\
+	fff_proto_t *_f = (fff_proto_t*)&BENCH_FIFO(p##_type, _exp);		\
+	const size_t _b = _min((1ul<<_exp), BENCH_BATCH);					\
+	_f->level = (1ul<<_exp);											\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		for (size_t k = 0; k < (1ul<<_exp); k += _b)					\
+		{																\
+			fff_read_multiple(_f, bench_dst_##_type, _b);				\
+			BENCH_USE(bench_dst_##_type);								\
+		}																\
+		_f->level = (1ul<<_exp);										\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_type, _exp, p_rebase)(uint64_t rounds)			\
+{																		\
+	fff_proto_t *_f = (fff_proto_t*)&BENCH_FIFO(p##_type, _exp);		\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		_f->read	= (1ul<<_exp)/2;									\
+		_f->write	= (1ul<<_exp)/2;									\
+		_f->level	= (1ul<<_exp);										\
+		fff_rebase(_f);													\
+		BENCH_BARRIER();												\
+	}																	\
+}																		\
+																		\
+static void BENCH_FN(_type, _exp, p_run)(void)							\
+{																		\
+	const size_t _d = (1ul<<_exp);										\
+	const size_t _b = _min(_d, BENCH_BATCH);							\
+	bench_run("fff_write", "pointable", sizeof(_type), _d, 1, _d, BENCH_FN(_type, _exp, p_write));	\
+	bench_run("fff_peek_read", "pointable", sizeof(_type), _d, 1, _d, BENCH_FN(_type, _exp, p_peek));	\
+	bench_run("fff_peek_write", "pointable", sizeof(_type), _d, 1, _d, BENCH_FN(_type, _exp, p_peek_write));	\
+	bench_run("fff_remove", "pointable", sizeof(_type), _d, 1, _d, BENCH_FN(_type, _exp, p_remove));	\
+	bench_run("fff_write_multiple", "pointable", sizeof(_type), _d, _b, _d/_b, BENCH_FN(_type, _exp, p_write_multiple));	\
+	bench_run("fff_read_multiple", "pointable", sizeof(_type), _d, _b, _d/_b, BENCH_FN(_type, _exp, p_read_multiple));	\
+	bench_run("fff_rebase", "pointable", sizeof(_type), _d, _d, 1, BENCH_FN(_type, _exp, p_rebase));	\
+}
+
+// all depths of 4^n for a single type, exact fifos with 3/4 of it; pointable fifos are limited to
+// 128 elements
+#define BENCH_CASES(_type)												\
+	BENCH_CASE(_type, 2)	BENCH_CASE(_type, 4)	BENCH_CASE(_type, 6)	\
+	BENCH_CASE(_type, 8)	BENCH_CASE(_type, 10)	BENCH_CASE(_type, 12)	\
+	BENCH_CASE(_type, 14)	BENCH_CASE(_type, 16)	BENCH_CASE(_type, 18)	\
+	BENCH_CASE(_type, 20)												\
+	BENCH_CASE_X(_type, 2)	BENCH_CASE_X(_type, 4)	BENCH_CASE_X(_type, 6)	\
+	BENCH_CASE_X(_type, 8)	BENCH_CASE_X(_type, 10)	BENCH_CASE_X(_type, 12)	\
+	BENCH_CASE_X(_type, 14)	BENCH_CASE_X(_type, 16)	BENCH_CASE_X(_type, 18)	\
+	BENCH_CASE_X(_type, 20)												\
+	BENCH_CASE_P(_type, 2)	BENCH_CASE_P(_type, 4)	BENCH_CASE_P(_type, 6)	\
+	BENCH_CASE_P(_type, 7)
+
+BENCH_CASES(uint8_t)
+BENCH_CASES(uint16_t)
+BENCH_CASES(uint32_t)
+BENCH_CASES(uint64_t)
+BENCH_CASES(bench_frame_t)
+
+#define BENCH_RUNS(_type)												\
+	{2, BENCH_FN(_type, 2, run)},	{2, BENCH_FN(x##_type, 2, run)},	{2, BENCH_FN(_type, 2, p_run)},	\
+	{4, BENCH_FN(_type, 4, run)},	{4, BENCH_FN(x##_type, 4, run)},	{4, BENCH_FN(_type, 4, p_run)},	\
+	{6, BENCH_FN(_type, 6, run)},	{6, BENCH_FN(x##_type, 6, run)},	{6, BENCH_FN(_type, 6, p_run)},	\
+	{7, BENCH_FN(_type, 7, p_run)},										\
+	{8, BENCH_FN(_type, 8, run)},	{8, BENCH_FN(x##_type, 8, run)},	\
+	{10, BENCH_FN(_type, 10, run)},	{10, BENCH_FN(x##_type, 10, run)},	\
+	{12, BENCH_FN(_type, 12, run)},	{12, BENCH_FN(x##_type, 12, run)},	\
+	{14, BENCH_FN(_type, 14, run)},	{14, BENCH_FN(x##_type, 14, run)},	\
+	{16, BENCH_FN(_type, 16, run)},	{16, BENCH_FN(x##_type, 16, run)},	\
+	{18, BENCH_FN(_type, 18, run)},	{18, BENCH_FN(x##_type, 18, run)},	\
+	{20, BENCH_FN(_type, 20, run)},	{20, BENCH_FN(x##_type, 20, run)},
+
+static const struct
+{
+	uint8_t exp;
+	void (*run)(void);
+} bench_cases[] =
+{
+	BENCH_RUNS(uint8_t)
+	BENCH_RUNS(uint16_t)
+	BENCH_RUNS(uint32_t)
+	BENCH_RUNS(uint64_t)
+	BENCH_RUNS(bench_frame_t)
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// Main
+//////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+	if (bench_parse(argc, argv, ""))
+		return 1;
+
+	for (size_t k = 0; k < BENCH_BATCH; k++)
+	{
+		bench_src_uint8_t[k]			= k;
+		bench_src_uint16_t[k]			= k;
+		bench_src_uint32_t[k]			= k;
+		bench_src_uint64_t[k]			= k;
+		memset(&bench_src_bench_frame_t[k], k, sizeof(bench_frame_t));
+	}
+
+	bench_begin();
+	for (size_t k = 0; k < sizeof(bench_cases)/sizeof(bench_cases[0]); k++)
+	{
+		if (bench_cases[k].exp <= bench_cfg.max_exp)
+			bench_cases[k].run();
+	}
+	bench_end();
+	return 0;
+}
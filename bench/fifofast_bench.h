@@ -0,0 +1,304 @@
+/*
+ * fifofast_bench.h
+ *
+ * Created: 17.10.2026 14:20:06
+ *
+ * Description:
+ * Minimal harness shared by the host benchmarks in this folder. Each benchmark case is a function
+ * running a given amount of rounds, where each round consists of a fixed amount of operations. The
+ * harness calibrates the amount of rounds until a run takes at least the minimum time, repeats the
+ * run BENCH_REPEAT times and reports the fastest one.
+ *
+ * Results are printed to stdout as CSV (default) or JSON (-j), one record per case. The columns
+ * 'op', 'variant', 'elem_size', 'depth' and 'batch' identify a case, so the output of two builds
+ * can be joined on them to find regressions. Cases which record a time per operation with
+ * bench_sample(...) also report its median and 99th percentile. If the kernel provides hardware
+ * counters, the cycles, instructions, cache misses and branch misses per operation of all threads
+ * of the process are reported, too (see _fff_perf_* in fifofast_linux.h); otherwise these columns
+ * are empty.
+ *
+ * The benchmarks require Linux and GCC or clang, they are not part of the AVR project.
+ * Define _GNU_SOURCE before including any header.
+ */
+
+
+#ifndef FIFOFAST_BENCH_H_
+#define FIFOFAST_BENCH_H_
+
+#include <stdint.h>			// required for data types (uint8_t, uint16_t, ...)
+#include <stdio.h>			// required for printf()
+#include <stdlib.h>			// required for strtoul()
+#include <string.h>			// required for strstr()
+#include <time.h>			// required for clock_gettime()
+#include <unistd.h>			// required for getopt(), syscall()
+#include <sched.h>			// required for sched_setaffinity()
+
+#include "../fifofast_linux.h"	// required for fff_perf_t
+
+
+//////////////////////////////////////////////////////////////////////////
+// User Config
+//////////////////////////////////////////////////////////////////////////
+
+// amount of measured runs per case; the fastest one is reported
+#define BENCH_REPEAT					3
+
+// default minimum duration of a single run in ms, can be changed with -t
+#define BENCH_MIN_TIME_MS				20
+
+// maximum amount of times per operation recorded by bench_sample(...) in a single run
+#define BENCH_SAMPLES					(1ul<<20)
+
+
+//////////////////////////////////////////////////////////////////////////
+// Data Structures
+//////////////////////////////////////////////////////////////////////////
+
+// runs 'rounds' rounds of a benchmark case
+typedef void (*bench_fn_t)(uint64_t rounds);
+
+// result of a single benchmark case
+typedef struct
+{
+	const char *op;					// measured macro or function, e.g. "_fff_write"
+	const char *variant;			// kind of fifo, e.g. "fifo" or "pointable"
+	size_t elem_size;				// bytes per element
+	size_t depth;					// elements the fifo can hold
+	size_t batch;					// elements moved by a single operation
+	uint64_t ops;					// operations of the fastest run
+	double ns_per_op;
+	double elems_per_s;
+	double p50_ns;					// median of the samples, < 0: not recorded
+	double p99_ns;					// 99th percentile of the samples, < 0: not recorded
+	double perf[FFF_PERF_EVENTS];	// hardware counts per operation, < 0: not available
+} bench_result_t;
+
+// settings from the command line
+typedef struct
+{
+	uint8_t json;					// !0: print JSON instead of CSV
+	uint8_t max_exp;				// largest depth is 2^max_exp
+	uint64_t min_ns;				// minimum duration of a single run
+	const char *filter;				// only ops containing this string are run, NULL: all
+	int cpu[2];						// cpus of the first (producer) and second (consumer) thread
+	uint32_t count;					// amount of results printed so far
+} bench_config_t;
+
+static bench_config_t bench_cfg = {0, 20, BENCH_MIN_TIME_MS*1000000ull, NULL, {0, 1}, 0};
+
+// times per operation of the current run, see bench_sample(...)
+static uint32_t bench_samples[BENCH_SAMPLES];
+static size_t bench_samples_n;
+
+// hardware counters of this and all threads created afterwards, opened by the first case
+static fff_perf_t bench_perf = {.fd = {-1, -1, -1, -1}, .leader = -1};
+static uint8_t bench_perf_opened;
+
+
+//////////////////////////////////////////////////////////////////////////
+// Macros
+//////////////////////////////////////////////////////////////////////////
+
+// forces the compiler to store 'x' to memory, so a value is not optimized away. Unlike a "memory"
+// clobber, the fifo indices may still be kept in registers.
+#define BENCH_USE(x)					__asm__ __volatile__("" : : "m"(x))
+
+// prevents the compiler from assuming anything about the memory, e.g. between two rounds
+#define BENCH_BARRIER()					__asm__ __volatile__("" : : : "memory")
+
+// tells the core that the thread is spinning
+#if defined(__x86_64__) || defined(__i386__)
+#define BENCH_PAUSE()					__builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define BENCH_PAUSE()					__asm__ __volatile__("yield")
+#else
+#define BENCH_PAUSE()					BENCH_BARRIER()
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////
+// Functions
+//////////////////////////////////////////////////////////////////////////
+
+// returns a monotonic timestamp in ns
+static inline uint64_t bench_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000000ull + ts.tv_nsec;
+}
+
+// returns !0 if the case 'op' passes the filter given by -f
+static inline uint8_t bench_enabled(const char *op)
+{
+	return bench_cfg.filter == NULL || strstr(op, bench_cfg.filter) != NULL;
+}
+
+// parses the command line; returns 0 on success
+static inline int bench_parse(int argc, char **argv, const char *usage)
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "jt:d:f:p:c:h")) != -1)
+	{
+		switch (opt)
+		{
+			case 'j': bench_cfg.json = 1; break;
+			case 't': bench_cfg.min_ns = strtoul(optarg, NULL, 0)*1000000ull; break;
+			case 'd': bench_cfg.max_exp = strtoul(optarg, NULL, 0); break;
+			case 'f': bench_cfg.filter = optarg; break;
+			case 'p': bench_cfg.cpu[0] = strtoul(optarg, NULL, 0); break;
+			case 'c': bench_cfg.cpu[1] = strtoul(optarg, NULL, 0); break;
+			default:
+				fprintf(stderr, "usage: %s [-j] [-t min_ms] [-d max_exp] [-f filter] [-p cpu] [-c cpu]\n%s", argv[0], usage);
+				return -1;
+		}
+	}
+	return 0;
+}
+
+// pins the calling thread to the cpu bench_cfg.cpu[idx]. If this is not possible (e.g. only a single
+// cpu is available), a warning is printed once and the thread runs on any cpu.
+static inline void bench_pin(uint8_t idx)
+{
+	static uint8_t warned;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(bench_cfg.cpu[idx], &set);
+	if (sched_setaffinity(0, sizeof(set), &set) != 0 && !__atomic_exchange_n(&warned, 1, __ATOMIC_RELAXED))
+		fprintf(stderr, "warning: cannot pin thread to cpu %d, results are not reliable\n", bench_cfg.cpu[idx]);
+}
+
+// records the time of a single operation, e.g. a round trip between two threads
+static inline void bench_sample(uint64_t ns)
+{
+	bench_samples[bench_samples_n % BENCH_SAMPLES] = (ns < UINT32_MAX) ? ns : UINT32_MAX;
+	bench_samples_n++;
+}
+
+static int bench_cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+	return (x > y) - (x < y);
+}
+
+// returns the time per round in ns of the fastest run of 'fn'. The samples of the fastest run are
+// kept in bench_samples[]. The hardware counts of all measured runs are accumulated in bench_perf,
+// where each round counts as 'ops' operations.
+static inline double bench_measure(bench_fn_t fn, uint64_t *rounds, uint64_t ops)
+{
+	// double the amount of rounds until a single run is long enough
+	uint64_t n = 1;
+	for (;;)
+	{
+		uint64_t t = bench_now();
+		fn(n);
+		t = bench_now() - t;
+		if (t >= bench_cfg.min_ns)
+			break;
+		n *= (t < bench_cfg.min_ns/16) ? 8 : 2;
+	}
+
+	double best = 0;
+	static uint32_t kept[BENCH_SAMPLES];
+	size_t kept_n = 0;
+	_fff_perf_reset(bench_perf);
+	_fff_perf_begin(bench_perf);
+	for (uint8_t k = 0; k < BENCH_REPEAT; k++)
+	{
+		bench_samples_n = 0;
+		uint64_t t = bench_now();
+		fn(n);
+		t = bench_now() - t;
+		if (k == 0 || (double)t/n < best)
+		{
+			best = (double)t/n;
+			kept_n = (bench_samples_n < BENCH_SAMPLES) ? bench_samples_n : BENCH_SAMPLES;
+			memcpy(kept, bench_samples, kept_n*sizeof(kept[0]));
+		}
+	}
+	_fff_perf_end(bench_perf, n*BENCH_REPEAT*ops);
+	memcpy(bench_samples, kept, kept_n*sizeof(kept[0]));
+	bench_samples_n = kept_n;
+	*rounds = n;
+	return best;
+}
+
+// prints the header of the output
+static inline void bench_begin(void)
+{
+	if (bench_cfg.json)
+		printf("[\n");
+	else
+		printf("op,variant,elem_size,depth,batch,ops,ns_per_op,elems_per_s,p50_ns,p99_ns,"
+			"cycles_per_op,instructions_per_op,cache_misses_per_op,branch_misses_per_op\n");
+}
+
+// prints an optional value; 'null' (JSON) or nothing (CSV) if it is negative
+static inline void bench_print_opt(const char *sep, const char *name, double value)
+{
+	if (bench_cfg.json)
+		printf(value < 0 ? "%s\"%s\": null" : "%s\"%s\": %.3f", sep, name, value);
+	else
+		printf(value < 0 ? "%s" : "%s%.3f", sep, value);
+}
+
+// prints a single result
+static inline void bench_print(const bench_result_t *r)
+{
+	if (bench_cfg.json)
+		printf("%s  {\"op\": \"%s\", \"variant\": \"%s\", \"elem_size\": %zu, \"depth\": %zu, \"batch\": %zu, "
+			"\"ops\": %llu, \"ns_per_op\": %.3f, \"elems_per_s\": %.0f",
+			bench_cfg.count ? ",\n" : "", r->op, r->variant, r->elem_size, r->depth, r->batch,
+			(unsigned long long)r->ops, r->ns_per_op, r->elems_per_s);
+	else
+		printf("%s,%s,%zu,%zu,%zu,%llu,%.3f,%.0f", r->op, r->variant, r->elem_size, r->depth, r->batch,
+			(unsigned long long)r->ops, r->ns_per_op, r->elems_per_s);
+	bench_print_opt(bench_cfg.json ? ", " : ",", "p50_ns", r->p50_ns);
+	bench_print_opt(bench_cfg.json ? ", " : ",", "p99_ns", r->p99_ns);
+	bench_print_opt(bench_cfg.json ? ", " : ",", "cycles_per_op", r->perf[FFF_PERF_CYCLES]);
+	bench_print_opt(bench_cfg.json ? ", " : ",", "instructions_per_op", r->perf[FFF_PERF_INSTRUCTIONS]);
+	bench_print_opt(bench_cfg.json ? ", " : ",", "cache_misses_per_op", r->perf[FFF_PERF_CACHE_MISSES]);
+	bench_print_opt(bench_cfg.json ? ", " : ",", "branch_misses_per_op", r->perf[FFF_PERF_BRANCH_MISSES]);
+	printf(bench_cfg.json ? "}" : "\n");
+	bench_cfg.count++;
+	fflush(stdout);
+}
+
+// prints the end of the output
+static inline void bench_end(void)
+{
+	if (bench_cfg.json)
+		printf("\n]\n");
+}
+
+// measures a case, where each round consists of 'ops' operations moving 'batch' elements each
+static inline void bench_run(const char *op, const char *variant, size_t elem_size, size_t depth,
+	size_t batch, uint64_t ops, bench_fn_t fn)
+{
+	if (!bench_enabled(op))
+		return;
+
+	if (!bench_perf_opened)
+	{
+		if (fff_perf_open(&bench_perf, "bench", 1) == 0)
+			fprintf(stderr, "warning: no hardware counters available\n");
+		bench_perf_opened = 1;
+	}
+	bench_perf.name = op;
+
+	uint64_t rounds;
+	double ns = bench_measure(fn, &rounds, ops) / ops;
+	bench_result_t r = {op, variant, elem_size, depth, batch, rounds*ops, ns, 1e9*batch/ns, -1, -1, {0}};
+	for (uint8_t k = 0; k < FFF_PERF_EVENTS; k++)
+		r.perf[k] = _fff_perf_per_op(bench_perf, k);
+	if (bench_samples_n)
+	{
+		qsort(bench_samples, bench_samples_n, sizeof(bench_samples[0]), bench_cmp_u32);
+		r.p50_ns = bench_samples[(bench_samples_n-1)*50/100];
+		r.p99_ns = bench_samples[(bench_samples_n-1)*99/100];
+	}
+	bench_print(&r);
+}
+
+
+#endif /* FIFOFAST_BENCH_H_ */
@@ -0,0 +1,452 @@
+/*
+ * fifofast_bench_mt.c
+ *
+ * Created: 17.10.2026 15:37:12
+ *
+ * Description:
+ * Cross-thread benchmark of the concurrent fifo variants. A producer and a consumer thread are
+ * pinned to two cpus (default 0 and 1, see -p and -c) and two measurements are made per variant:
+ *
+ * "pingpong":   the producer sends an element through a fifo, the consumer returns it through a
+ *               second fifo of the same variant. The time of each round trip is recorded; p50_ns
+ *               and p99_ns are its median and 99th percentile.
+ * "throughput": the producer writes a continuous stream of elements, 'batch' elements per call, as
+ *               fast as the consumer reads them. ns_per_op is the time per call, elems_per_s the
+ *               sustained one-way rate.
+ *
+ * The baselines "mutex" and "spinlock" are regular fifos, where every call is protected by a
+ * pthread mutex or a spinlock. Batches use _fff_write_multiple(...)/_fff_read_multiple(...) for
+ * them and _fff_spsc_write_reserve(...)/_fff_spsc_read_acquire(...) for spsc fifos. mpmc and mpsc
+ * fifos have no batch macros, so a batch is a loop of single calls. "spsc_batch" uses
+ * _fff_spsc_write_batch(...)/_fff_spsc_read_batch(...), which publish every FIFOFAST_SPSC_BATCH
+ * elements. Each variant is measured with elements of 4, 8 and 32 bytes and a depth of
+ * BENCH_MT_DEPTH.
+ *
+ * Threads waiting for data or space spin and yield the cpu every BENCH_MT_YIELD spins, so the
+ * benchmark completes on a single cpu as well, but only results of two pinned cpus are meaningful.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -pthread -o fifofast_bench_mt bench/fifofast_bench_mt.c
+ *   ./fifofast_bench_mt -p 2 -c 3 > mt.csv
+ *   ./fifofast_bench_mt -f pingpong -j
+ *
+ * Options: see fifofast_bench.c; -d is ignored, -p/-c select the cpus of producer/consumer.
+ */
+
+#define _GNU_SOURCE			// required for sched_setaffinity() in fifofast_bench.h
+
+#include <pthread.h>		// required for pthread_create(), pthread_mutex_*()
+
+#include "../fifofast.h"
+#include "fifofast_bench.h"
+
+
+//////////////////////////////////////////////////////////////////////////
+// Benchmark Config
+//////////////////////////////////////////////////////////////////////////
+
+// depth of all fifos
+#define BENCH_MT_DEPTH					1024
+
+// elements per round of the throughput measurement; must be a multiple of the largest batch
+#define BENCH_MT_ROUND					4096
+
+// largest batch of the throughput measurement
+#define BENCH_MT_BATCH_MAX				64
+
+// amount of spins after which a waiting thread yields the cpu
+#define BENCH_MT_YIELD					1024
+
+// element of 32 bytes, like 'frame_u' of the demo
+typedef struct
+{
+	uint8_t raw[32];
+} bench_frame_t;
+
+
+//////////////////////////////////////////////////////////////////////////
+// Variants
+//////////////////////////////////////////////////////////////////////////
+
+// Each variant 'V' provides the following macros, which are used by BENCH_MT_CASE(...):
+// BENCH_DECL_V(_type, _id):		declares and initializes the fifo '_id'
+// BENCH_WRITE_V(_id, x):			writes 'x' if space is available; returns !0 on success
+// BENCH_READ_V(_id, p):			reads an element to '*p' if available; returns !0 on success
+// BENCH_WRITE_N_V(_id, src, n):	writes up to 'n' elements from 'src'; returns the amount written
+// BENCH_READ_N_V(_id, dst, n):		reads up to 'n' elements to 'dst'; returns the amount read
+// BENCH_FLUSH_V(_id):				called by the producer after its last write
+
+// writes elements one by one until the fifo is full
+#define BENCH_WRITE_LOOP(V, _id, src, n)								\
+({																		\
+	size_t _lp_k = 0;													\
+	while (_lp_k < (n) && BENCH_WRITE_##V(_id, (src)[_lp_k]))			\
+		_lp_k++;														\
+	_lp_k;																\
+})
+
+// reads elements one by one until the fifo is empty
+#define BENCH_READ_LOOP(V, _id, dst, n)									\
+({																		\
+	size_t _lp_k = 0;													\
+	while (_lp_k < (n) && BENCH_READ_##V(_id, &(dst)[_lp_k]))			\
+		_lp_k++;														\
+	_lp_k;																\
+})
+
+// copies 'n' elements from/ to the blocks of a span
+#define BENCH_SPAN_TO(span, src, _type)									\
+do{																		\
+	memcpy((span).ptr[0], (src), (span).len[0]*sizeof(_type));			\
+	memcpy((span).ptr[1], (src)+(span).len[0], (span).len[1]*sizeof(_type));	\
+}while(0)
+#define BENCH_SPAN_FROM(span, dst, _type)								\
+do{																		\
+	memcpy((dst), (span).ptr[0], (span).len[0]*sizeof(_type));			\
+	memcpy((dst)+(span).len[0], (span).ptr[1], (span).len[1]*sizeof(_type));	\
+}while(0)
+
+// regular fifo protected by a pthread mutex
+#define BENCH_DECL_mutex(_type, _id)									\
+	static _fff_declare(_type, _id, BENCH_MT_DEPTH);					\
+	static _fff_init(_id);												\
+	static pthread_mutex_t _id##_lock = PTHREAD_MUTEX_INITIALIZER;
+#define BENCH_WRITE_mutex(_id, x)										\
+({																		\
+	pthread_mutex_lock(&_id##_lock);									\
+	uint8_t _v_r = !_fff_is_full(_id);									\
+	if (_v_r)															\
+		_fff_write_lite(_id, x);										\
+	pthread_mutex_unlock(&_id##_lock);									\
+	_v_r;																\
+})
+#define BENCH_READ_mutex(_id, p)										\
+({																		\
+	pthread_mutex_lock(&_id##_lock);									\
+	uint8_t _v_r = !_fff_is_empty(_id);									\
+	if (_v_r)															\
+		*(p) = _fff_read_lite(_id);										\
+	pthread_mutex_unlock(&_id##_lock);									\
+	_v_r;																\
+})
+#define BENCH_WRITE_N_mutex(_id, src, n)								\
+({																		\
+	pthread_mutex_lock(&_id##_lock);									\
+	size_t _v_r = _fff_write_multiple(_id, src, n);						\
+	pthread_mutex_unlock(&_id##_lock);									\
+	_v_r;																\
+})
+#define BENCH_READ_N_mutex(_id, dst, n)									\
+({																		\
+	pthread_mutex_lock(&_id##_lock);									\
+	size_t _v_r = _fff_read_multiple(_id, dst, n);						\
+	pthread_mutex_unlock(&_id##_lock);									\
+	_v_r;																\
+})
+#define BENCH_FLUSH_mutex(_id)
+
+// regular fifo protected by a test-and-test-and-set spinlock
+#define BENCH_SPIN_LOCK(lock)											\
+do{																		\
+	while (__atomic_exchange_n(&(lock), 1, __ATOMIC_ACQUIRE))			\
+		while (__atomic_load_n(&(lock), __ATOMIC_RELAXED))				\
+			BENCH_PAUSE();												\
+}while(0)
+#define BENCH_SPIN_UNLOCK(lock)			__atomic_store_n(&(lock), 0, __ATOMIC_RELEASE)
+
+#define BENCH_DECL_spinlock(_type, _id)									\
+	static _fff_declare(_type, _id, BENCH_MT_DEPTH);					\
+	static _fff_init(_id);												\
+	static uint8_t _id##_lock;
+#define BENCH_WRITE_spinlock(_id, x)									\
+({																		\
+	BENCH_SPIN_LOCK(_id##_lock);										\
+	uint8_t _v_r = !_fff_is_full(_id);									\
+	if (_v_r)															\
+		_fff_write_lite(_id, x);										\
+	BENCH_SPIN_UNLOCK(_id##_lock);										\
+	_v_r;																\
+})
+#define BENCH_READ_spinlock(_id, p)										\
+({																		\
+	BENCH_SPIN_LOCK(_id##_lock);										\
+	uint8_t _v_r = !_fff_is_empty(_id);									\
+	if (_v_r)															\
+		*(p) = _fff_read_lite(_id);										\
+	BENCH_SPIN_UNLOCK(_id##_lock);										\
+	_v_r;																\
+})
+#define BENCH_WRITE_N_spinlock(_id, src, n)								\
+({																		\
+	BENCH_SPIN_LOCK(_id##_lock);										\
+	size_t _v_r = _fff_write_multiple(_id, src, n);						\
+	BENCH_SPIN_UNLOCK(_id##_lock);										\
+	_v_r;																\
+})
+#define BENCH_READ_N_spinlock(_id, dst, n)								\
+({																		\
+	BENCH_SPIN_LOCK(_id##_lock);										\
+	size_t _v_r = _fff_read_multiple(_id, dst, n);						\
+	BENCH_SPIN_UNLOCK(_id##_lock);										\
+	_v_r;																\
+})
+#define BENCH_FLUSH_spinlock(_id)
+
+// lock-free spsc fifo; batches use the zero-copy macros
+#define BENCH_DECL_spsc(_type, _id)										\
+	static _fff_declare_spsc(_type, _id, BENCH_MT_DEPTH);				\
+	static _fff_init_spsc(_id);
+#define BENCH_WRITE_spsc(_id, x)		_fff_spsc_write(_id, x)
+#define BENCH_READ_spsc(_id, p)			_fff_spsc_read(_id, p)
+#define BENCH_WRITE_N_spsc(_id, src, n)									\
+({																		\
+	fff_span_t _v_s = _fff_spsc_write_reserve(_id, n);					\
+	BENCH_SPAN_TO(_v_s, src, _id.data[0]);								\
+	_fff_spsc_write_commit(_id, _v_s.len[0]+_v_s.len[1]);				\
+	_v_s.len[0]+_v_s.len[1];											\
+})
+#define BENCH_READ_N_spsc(_id, dst, n)									\
+({																		\
+	fff_span_t _v_s = _fff_spsc_read_acquire(_id, n);					\
+	BENCH_SPAN_FROM(_v_s, dst, _id.data[0]);							\
+	_fff_spsc_read_release(_id, _v_s.len[0]+_v_s.len[1]);				\
+	_v_s.len[0]+_v_s.len[1];											\
+})
+#define BENCH_FLUSH_spsc(_id)
+
+// lock-free spsc fifo with producer, consumer and data on separate cache lines
+#define BENCH_DECL_spsc_cl(_type, _id)									\
+	static _fff_declare_spsc_cl(_type, _id, BENCH_MT_DEPTH);			\
+	static _fff_init_spsc(_id);
+#define BENCH_WRITE_spsc_cl(_id, x)			BENCH_WRITE_spsc(_id, x)
+#define BENCH_READ_spsc_cl(_id, p)			BENCH_READ_spsc(_id, p)
+#define BENCH_WRITE_N_spsc_cl(_id, src, n)	BENCH_WRITE_N_spsc(_id, src, n)
+#define BENCH_READ_N_spsc_cl(_id, dst, n)	BENCH_READ_N_spsc(_id, dst, n)
+#define BENCH_FLUSH_spsc_cl(_id)
+
+// lock-free spsc fifo, which publishes its indices every FIFOFAST_SPSC_BATCH elements
+#define BENCH_DECL_spsc_batch(_type, _id)	BENCH_DECL_spsc_cl(_type, _id)
+#define BENCH_WRITE_spsc_batch(_id, x)		_fff_spsc_write_batch(_id, x)
+#define BENCH_READ_spsc_batch(_id, p)		_fff_spsc_read_batch(_id, p)
+#define BENCH_WRITE_N_spsc_batch(_id, src, n)	BENCH_WRITE_LOOP(spsc_batch, _id, src, n)
+#define BENCH_READ_N_spsc_batch(_id, dst, n)	BENCH_READ_LOOP(spsc_batch, _id, dst, n)
+#define BENCH_FLUSH_spsc_batch(_id)			_fff_spsc_flush(_id)
+
+// lock-free mpmc fifo
+#define BENCH_DECL_mpmc(_type, _id)										\
+	static _fff_declare_mpmc(_type, _id, BENCH_MT_DEPTH);				\
+	static _fff_init_mpmc(_id);
+#define BENCH_WRITE_mpmc(_id, x)			_fff_mpmc_write(_id, x)
+#define BENCH_READ_mpmc(_id, p)				_fff_mpmc_read(_id, p)
+#define BENCH_WRITE_N_mpmc(_id, src, n)		BENCH_WRITE_LOOP(mpmc, _id, src, n)
+#define BENCH_READ_N_mpmc(_id, dst, n)		BENCH_READ_LOOP(mpmc, _id, dst, n)
+#define BENCH_FLUSH_mpmc(_id)
+
+// lock-free mpmc fifo with indices and data on separate cache lines
+#define BENCH_DECL_mpmc_cl(_type, _id)									\
+	static _fff_declare_mpmc_cl(_type, _id, BENCH_MT_DEPTH);			\
+	static _fff_init_mpmc(_id);
+#define BENCH_WRITE_mpmc_cl(_id, x)			_fff_mpmc_write(_id, x)
+#define BENCH_READ_mpmc_cl(_id, p)			_fff_mpmc_read(_id, p)
+#define BENCH_WRITE_N_mpmc_cl(_id, src, n)	BENCH_WRITE_LOOP(mpmc_cl, _id, src, n)
+#define BENCH_READ_N_mpmc_cl(_id, dst, n)	BENCH_READ_LOOP(mpmc_cl, _id, dst, n)
+#define BENCH_FLUSH_mpmc_cl(_id)
+
+// lock-free mpsc fifo
+#define BENCH_DECL_mpsc(_type, _id)										\
+	static _fff_declare_mpsc(_type, _id, BENCH_MT_DEPTH);				\
+	static _fff_init_mpsc(_id);
+#define BENCH_WRITE_mpsc(_id, x)			_fff_mpsc_write(_id, x)
+#define BENCH_READ_mpsc(_id, p)				_fff_mpsc_read(_id, p)
+#define BENCH_WRITE_N_mpsc(_id, src, n)		BENCH_WRITE_LOOP(mpsc, _id, src, n)
+#define BENCH_READ_N_mpsc(_id, dst, n)		BENCH_READ_LOOP(mpsc, _id, dst, n)
+#define BENCH_FLUSH_mpsc(_id)
+
+// lock-free mpsc fifo with indices and data on separate cache lines
+#define BENCH_DECL_mpsc_cl(_type, _id)									\
+	static _fff_declare_mpsc_cl(_type, _id, BENCH_MT_DEPTH);			\
+	static _fff_init_mpsc(_id);
+#define BENCH_WRITE_mpsc_cl(_id, x)			_fff_mpsc_write(_id, x)
+#define BENCH_READ_mpsc_cl(_id, p)			_fff_mpsc_read(_id, p)
+#define BENCH_WRITE_N_mpsc_cl(_id, src, n)	BENCH_WRITE_LOOP(mpsc_cl, _id, src, n)
+#define BENCH_READ_N_mpsc_cl(_id, dst, n)	BENCH_READ_LOOP(mpsc_cl, _id, dst, n)
+#define BENCH_FLUSH_mpsc_cl(_id)
+
+
+//////////////////////////////////////////////////////////////////////////
+// Benchmark Cases
+//////////////////////////////////////////////////////////////////////////
+
+// waits a bit before the next try; yields the cpu from time to time, so a thread waiting for
+// another thread on the same cpu doesn't spin for its whole time slice
+static inline void bench_mt_wait(uint32_t *spins)
+{
+	if (++*spins % BENCH_MT_YIELD == 0)
+		sched_yield();
+	else
+		BENCH_PAUSE();
+}
+
+// runs 'fn' on a new thread pinned to the consumer cpu
+static inline pthread_t bench_mt_start(void *(*fn)(void*), uint64_t rounds)
+{
+	pthread_t thread;
+	pthread_create(&thread, NULL, fn, (void*)(uintptr_t)rounds);
+	return thread;
+}
+
+// batch size of the current throughput measurement
+static size_t bench_mt_batch;
+
+// source and destination of the elements of each type
+#define BENCH_TYPE(_type)												\
+static _type bench_src_##_type[BENCH_MT_BATCH_MAX];
+
+BENCH_TYPE(uint32_t)
+BENCH_TYPE(uint64_t)
+BENCH_TYPE(bench_frame_t)
+
+// declares both fifos and all benchmarks of variant 'V' with elements of '_type'
+#define BENCH_MT_CASE(V, _type)											\
+BENCH_DECL_##V(_type, bench_ping_##V##_##_type)							\
+BENCH_DECL_##V(_type, bench_pong_##V##_##_type)							\
+																		\
+/* consumer of the ping-pong: returns every element */					\
+static void* bench_echo_##V##_##_type(void *arg)						\
+{																		\
+	uint64_t _mt_n = (uintptr_t)arg;									\
+	uint32_t _mt_spins = 0;												\
+	_type _mt_x;														\
+	bench_pin(1);														\
+	for (uint64_t r = 0; r < _mt_n; r++)								\
+	{																	\
+		while (!BENCH_READ_##V(bench_ping_##V##_##_type, &_mt_x))		\
+			bench_mt_wait(&_mt_spins);									\
+		while (!BENCH_WRITE_##V(bench_pong_##V##_##_type, _mt_x))		\
+			bench_mt_wait(&_mt_spins);									\
+		BENCH_FLUSH_##V(bench_pong_##V##_##_type);						\
+	}																	\
+	return NULL;														\
+}																		\
+																		\
+static void bench_pingpong_##V##_##_type(uint64_t rounds)				\
+{																		\
+	pthread_t _mt_t = bench_mt_start(bench_echo_##V##_##_type, rounds);	\
+	uint32_t _mt_spins = 0;												\
+	_type _mt_x = bench_src_##_type[0];									\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		uint64_t _mt_start = bench_now();								\
+		while (!BENCH_WRITE_##V(bench_ping_##V##_##_type, _mt_x))		\
+			bench_mt_wait(&_mt_spins);									\
+		BENCH_FLUSH_##V(bench_ping_##V##_##_type);						\
+		while (!BENCH_READ_##V(bench_pong_##V##_##_type, &_mt_x))		\
+			bench_mt_wait(&_mt_spins);									\
+		bench_sample(bench_now() - _mt_start);							\
+	}																	\
+	pthread_join(_mt_t, NULL);											\
+}																		\
+																		\
+/* consumer of the throughput measurement: reads all elements */		\
+static void* bench_sink_##V##_##_type(void *arg)						\
+{																		\
+	uint64_t _mt_n = (uintptr_t)arg * BENCH_MT_ROUND;					\
+	uint32_t _mt_spins = 0;												\
+	_type _mt_buf[BENCH_MT_BATCH_MAX];									\
+	bench_pin(1);														\
+	for (uint64_t _mt_k = 0; _mt_k < _mt_n; )							\
+	{																	\
+		size_t _mt_r = BENCH_READ_N_##V(bench_ping_##V##_##_type, _mt_buf, bench_mt_batch);	\
+		if (_mt_r == 0)													\
+			bench_mt_wait(&_mt_spins);									\
+		BENCH_USE(_mt_buf);												\
+		_mt_k += _mt_r;													\
+	}																	\
+	return NULL;														\
+}																		\
+																		\
+static void bench_throughput_##V##_##_type(uint64_t rounds)				\
+{																		\
+	pthread_t _mt_t = bench_mt_start(bench_sink_##V##_##_type, rounds);	\
+	uint64_t _mt_n = rounds * BENCH_MT_ROUND;							\
+	uint32_t _mt_spins = 0;												\
+	for (uint64_t _mt_k = 0; _mt_k < _mt_n; )							\
+	{																	\
+		size_t _mt_w = BENCH_WRITE_N_##V(bench_ping_##V##_##_type, bench_src_##_type, bench_mt_batch);	\
+		if (_mt_w == 0)													\
+			bench_mt_wait(&_mt_spins);									\
+		_mt_k += _mt_w;													\
+	}																	\
+	BENCH_FLUSH_##V(bench_ping_##V##_##_type);							\
+	pthread_join(_mt_t, NULL);											\
+}																		\
+																		\
+static void bench_run_##V##_##_type(void)								\
+{																		\
+	static const size_t _mt_batches[] = {1, 8, BENCH_MT_BATCH_MAX};		\
+	bench_run("pingpong", #V, sizeof(_type), BENCH_MT_DEPTH, 1, 1, bench_pingpong_##V##_##_type);	\
+	for (size_t _mt_b = 0; _mt_b < sizeof(_mt_batches)/sizeof(_mt_batches[0]); _mt_b++)	\
+	{																	\
+		bench_mt_batch = _mt_batches[_mt_b];							\
+		bench_run("throughput", #V, sizeof(_type), BENCH_MT_DEPTH, bench_mt_batch,	\
+			BENCH_MT_ROUND/bench_mt_batch, bench_throughput_##V##_##_type);	\
+	}																	\
+}
+
+#define BENCH_MT_CASES(V)												\
+	BENCH_MT_CASE(V, uint32_t)											\
+	BENCH_MT_CASE(V, uint64_t)											\
+	BENCH_MT_CASE(V, bench_frame_t)
+
+BENCH_MT_CASES(mutex)
+BENCH_MT_CASES(spinlock)
+BENCH_MT_CASES(spsc)
+BENCH_MT_CASES(spsc_cl)
+BENCH_MT_CASES(spsc_batch)
+BENCH_MT_CASES(mpmc)
+BENCH_MT_CASES(mpmc_cl)
+BENCH_MT_CASES(mpsc)
+BENCH_MT_CASES(mpsc_cl)
+
+#define BENCH_MT_RUNS(V)												\
+	bench_run_##V##_uint32_t,											\
+	bench_run_##V##_uint64_t,											\
+	bench_run_##V##_bench_frame_t,
+
+static void (*const bench_cases[])(void) =
+{
+	BENCH_MT_RUNS(mutex)
+	BENCH_MT_RUNS(spinlock)
+	BENCH_MT_RUNS(spsc)
+	BENCH_MT_RUNS(spsc_cl)
+	BENCH_MT_RUNS(spsc_batch)
+	BENCH_MT_RUNS(mpmc)
+	BENCH_MT_RUNS(mpmc_cl)
+	BENCH_MT_RUNS(mpsc)
+	BENCH_MT_RUNS(mpsc_cl)
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// Main
+//////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+	if (bench_parse(argc, argv, ""))
+		return 1;
+
+	for (size_t k = 0; k < BENCH_MT_BATCH_MAX; k++)
+	{
+		bench_src_uint32_t[k]			= k;
+		bench_src_uint64_t[k]			= k;
+		memset(&bench_src_bench_frame_t[k], k, sizeof(bench_frame_t));
+	}
+
+	bench_pin(0);
+	bench_begin();
+	for (size_t k = 0; k < sizeof(bench_cases)/sizeof(bench_cases[0]); k++)
+		bench_cases[k]();
+	bench_end();
+	return 0;
+}
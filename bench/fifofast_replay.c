@@ -0,0 +1,562 @@
+/*
+ * fifofast_replay.c
+ *
+ * Created: 17.10.2026 18:02:41
+ *
+ * Description:
+ * Replays a trace recorded with FFF_OPT_TRACE and _fff_trace_open(...) (see fifofast_linux.h)
+ * against fifos of other depths and variants, so the depth and the kind of a fifo can be chosen
+ * from its real access pattern instead of a guess. Each operation of the trace is applied with the
+ * same count to every fifo:
+ *
+ * "fifo":      regular fifo, full fifos dismiss new elements (_fff_write, _fff_write_multiple, ...)
+ * "overwrite": regular fifo with FFF_OPT_OVERWRITE, full fifos evict the oldest elements
+ * "spsc":      lock-free spsc fifo, batches use _fff_spsc_write_reserve(...)/_read_acquire(...)
+ * "mpmc":      lock-free mpmc fifo, batches are loops of single calls; peeks are skipped
+ *
+ * The trace is replayed by a single thread, so the lock-free variants show the cost of their
+ * atomic operations, but not of any contention. The element size of the recorded fifo selects the
+ * element type (1, 2, 4, 8 or 32 bytes); all depths from 4 to 2^exp are replayed.
+ *
+ * For each variant and depth one line of CSV is printed:
+ *   records:    amount of operations in the trace
+ *   ns_per_op:  average time of an operation, best of BENCH_REPEAT runs
+ *   offered:    elements written by the trace
+ *   drops:      elements dismissed or evicted by a full fifo; drop_pct relative to 'offered'
+ *   max_level:  highest fill level
+ *   mean_level: fill level averaged over the time of the trace
+ *   full_pct:   share of the time the fifo was full
+ * With -o the fill level over time is written to a second CSV file, one sample every -i ns of
+ * trace time. If the recording machine had no timestamps (ns_per_tick is 0), each record counts
+ * as 1 ns.
+ *
+ * Build and run from the repository root:
+ *   gcc -O2 -o fifofast_replay bench/fifofast_replay.c
+ *   ./fifofast_replay rx.trace > rx.csv
+ *   ./fifofast_replay -f spsc -d 10 -o rx_level.csv rx.trace
+ *
+ * Options:
+ *   -t ms		minimum duration of a single run, default BENCH_MIN_TIME_MS
+ *   -d exp		largest depth is 2^exp, default 16
+ *   -f text	only replay variants containing 'text'
+ *   -o file	write the fill level over time to 'file'
+ *   -i ns		interval between two samples of -o, default 1/1000 of the trace
+ *   -c			replay a built-in trace with known results instead of a file; returns !0 on mismatch
+ */
+
+#define _GNU_SOURCE			// required for sched_setaffinity() in fifofast_bench.h
+
+#include "../fifofast.h"
+#include "fifofast_bench.h"
+
+
+//////////////////////////////////////////////////////////////////////////
+// Replay Config
+//////////////////////////////////////////////////////////////////////////
+
+// largest depth which can be replayed is 2^REPLAY_EXP_MAX
+#define REPLAY_EXP_MAX					16
+
+// largest amount of elements moved by a single call; larger counts of the trace are split
+#define REPLAY_CHUNK					256
+
+// element of 32 bytes, like 'frame_u' of the demo
+typedef struct
+{
+	uint8_t raw[32];
+} replay_frame_t;
+
+
+//////////////////////////////////////////////////////////////////////////
+// Trace and Occupancy
+//////////////////////////////////////////////////////////////////////////
+
+// the trace to replay
+static fff_trace_header_t replay_header;
+static fff_trace_rec_t *replay_rec;
+static size_t replay_n;
+static double replay_ns_per_tick;
+
+// source and destination of all written/ read elements
+static uint8_t replay_buf[REPLAY_CHUNK * sizeof(replay_frame_t)] __attribute__((aligned(64)));
+
+// fill level of a single replay
+typedef struct
+{
+	const char *variant;
+	size_t depth;
+	uint64_t offered;				// elements written by the trace
+	uint64_t drops;					// elements dismissed or evicted
+	size_t max_level;
+	double level_ns;				// sum of level * time
+	double full_ns;					// time the fifo was full
+	double now;						// time of the current record in ns
+	FILE *series;					// fill level over time, NULL: not recorded
+	double interval;				// time between two samples of 'series'
+	double next;					// time of the next sample
+} replay_obs_t;
+
+// accounts for the time before a record, during which the fifo held 'level' elements
+static inline void replay_observe(replay_obs_t *obs, uint32_t time, size_t level)
+{
+	double ns = time * replay_ns_per_tick;
+	while (obs->series != NULL && obs->next <= obs->now + ns)
+	{
+		fprintf(obs->series, "%s,%zu,%.0f,%zu\n", obs->variant, obs->depth, obs->next, level);
+		obs->next += obs->interval;
+	}
+	obs->now		+= ns;
+	obs->level_ns	+= level * ns;
+	if (level >= obs->depth)
+		obs->full_ns += ns;
+	if (level > obs->max_level)
+		obs->max_level = level;
+}
+
+// loads the trace file 'path'; returns 0 on success
+static int replay_load(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	long size;
+	if (file == NULL)
+	{
+		perror(path);
+		return -1;
+	}
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (fread(&replay_header, sizeof(replay_header), 1, file) != 1
+		|| memcmp(replay_header.magic, "FFFT", 4) != 0 || replay_header.version != FFF_TRACE_VERSION)
+	{
+		fprintf(stderr, "%s: not a trace file of version %d\n", path, FFF_TRACE_VERSION);
+		fclose(file);
+		return -1;
+	}
+	replay_n = (size - sizeof(replay_header)) / sizeof(fff_trace_rec_t);
+	replay_rec = malloc(replay_n * sizeof(fff_trace_rec_t) + 1);
+	if (replay_rec == NULL || fread(replay_rec, sizeof(fff_trace_rec_t), replay_n, file) != replay_n)
+	{
+		fprintf(stderr, "%s: can't read %zu records\n", path, replay_n);
+		fclose(file);
+		return -1;
+	}
+	fclose(file);
+	replay_ns_per_tick = (replay_header.ns_per_tick > 0) ? replay_header.ns_per_tick : 0;
+	return 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Variants
+//////////////////////////////////////////////////////////////////////////
+
+// Each variant 'V' provides the following macros, which are used by REPLAY_CASE(...):
+// REPLAY_DECL_V(_type, _id, _depth):	declares and initializes the fifo '_id'
+// REPLAY_LEVEL_V(_id):				returns the fill level
+// REPLAY_WRITE_V(_id, src, n):		writes 'n' elements from 'src', 1 <= n <= REPLAY_CHUNK
+// REPLAY_READ_V(_id, dst, n):		reads up to 'n' elements to 'dst', 1 <= n <= REPLAY_CHUNK
+// REPLAY_PEEK_V(_id, idx):			reads the element 'idx' without removing it, if it exists
+// REPLAY_REMOVE_V(_id, n):			removes up to 'n' elements
+// REPLAY_RESET_V(_id):				removes all elements
+// REPLAY_REBASE_V(_id):			moves the first element to the start of the array, if possible
+
+// regular fifo, dismisses new elements if full
+#define REPLAY_DECL_fifo(_type, _id, _depth)							\
+	static _fff_declare(_type, _id, _depth);							\
+	static _fff_init(_id);
+#define REPLAY_LEVEL_fifo(_id)			_fff_mem_level(_id)
+#define REPLAY_WRITE_fifo(_id, src, n)									\
+do{																		\
+	if ((n) == 1)														\
+		_fff_write(_id, (src)[0]);										\
+	else																\
+		_fff_write_multiple(_id, src, n);								\
+}while(0)
+#define REPLAY_READ_fifo(_id, dst, n)									\
+do{																		\
+	if ((n) == 1)														\
+		(dst)[0] = _fff_read(_id);										\
+	else																\
+		_fff_read_multiple(_id, dst, n);								\
+}while(0)
+#define REPLAY_PEEK_fifo(_id, idx)										\
+do{																		\
+	if ((idx) < _fff_mem_level(_id))									\
+		BENCH_USE(_fff_peek(_id, idx));									\
+}while(0)
+#define REPLAY_REMOVE_fifo(_id, n)		_fff_remove(_id, n)
+#define REPLAY_RESET_fifo(_id)			_fff_reset(_id)
+#define REPLAY_REBASE_fifo(_id)			_fff_rebase(_id)
+
+// regular fifo, evicts the oldest elements if full
+#define REPLAY_DECL_overwrite(_type, _id, _depth)						\
+	static _fff_declare(_type, _id, _depth, FFF_OPT_OVERWRITE);			\
+	static _fff_init(_id);
+#define REPLAY_LEVEL_overwrite(_id)			REPLAY_LEVEL_fifo(_id)
+#define REPLAY_WRITE_overwrite(_id, src, n)	REPLAY_WRITE_fifo(_id, src, n)
+#define REPLAY_READ_overwrite(_id, dst, n)	REPLAY_READ_fifo(_id, dst, n)
+#define REPLAY_PEEK_overwrite(_id, idx)		REPLAY_PEEK_fifo(_id, idx)
+#define REPLAY_REMOVE_overwrite(_id, n)		REPLAY_REMOVE_fifo(_id, n)
+#define REPLAY_RESET_overwrite(_id)			REPLAY_RESET_fifo(_id)
+#define REPLAY_REBASE_overwrite(_id)		REPLAY_REBASE_fifo(_id)
+
+// lock-free spsc fifo; batches use the zero-copy macros
+#define REPLAY_DECL_spsc(_type, _id, _depth)							\
+	static _fff_declare_spsc(_type, _id, _depth);						\
+	static _fff_init_spsc(_id);
+#define REPLAY_LEVEL_spsc(_id)			_fff_spsc_mem_level(_id)
+#define REPLAY_WRITE_spsc(_id, src, n)									\
+do{																		\
+	if ((n) == 1)														\
+		_fff_spsc_write(_id, (src)[0]);									\
+	else																\
+	{																	\
+		fff_span_t _v_s = _fff_spsc_write_reserve(_id, n);				\
+		memcpy(_v_s.ptr[0], (src), _v_s.len[0]*sizeof((src)[0]));		\
+		memcpy(_v_s.ptr[1], (src)+_v_s.len[0], _v_s.len[1]*sizeof((src)[0]));	\
+		_fff_spsc_write_commit(_id, _v_s.len[0]+_v_s.len[1]);			\
+	}																	\
+}while(0)
+#define REPLAY_READ_spsc(_id, dst, n)									\
+do{																		\
+	if ((n) == 1)														\
+		_fff_spsc_read(_id, &(dst)[0]);									\
+	else																\
+	{																	\
+		fff_span_t _v_s = _fff_spsc_read_acquire(_id, n);				\
+		memcpy((dst), _v_s.ptr[0], _v_s.len[0]*sizeof((dst)[0]));		\
+		memcpy((dst)+_v_s.len[0], _v_s.ptr[1], _v_s.len[1]*sizeof((dst)[0]));	\
+		_fff_spsc_read_release(_id, _v_s.len[0]+_v_s.len[1]);			\
+	}																	\
+}while(0)
+#define REPLAY_PEEK_spsc(_id, idx)										\
+do{																		\
+	if ((idx) < _fff_spsc_mem_level(_id))								\
+		BENCH_USE(_fff_spsc_peek(_id, idx));							\
+}while(0)
+#define REPLAY_REMOVE_spsc(_id, n)		_fff_spsc_remove(_id, n)
+#define REPLAY_RESET_spsc(_id)			_fff_spsc_reset(_id)
+#define REPLAY_REBASE_spsc(_id)
+
+// lock-free mpmc fifo; no batch, peek or remove macros
+#define REPLAY_DECL_mpmc(_type, _id, _depth)							\
+	static _fff_declare_mpmc(_type, _id, _depth);						\
+	static _fff_init_mpmc(_id);
+#define REPLAY_LEVEL_mpmc(_id)			_fff_mpmc_mem_level(_id)
+#define REPLAY_WRITE_mpmc(_id, src, n)									\
+do{																		\
+	for (size_t _v_k = 0; _v_k < (n) && _fff_mpmc_write(_id, (src)[_v_k]); _v_k++);	\
+}while(0)
+#define REPLAY_READ_mpmc(_id, dst, n)									\
+do{																		\
+	for (size_t _v_k = 0; _v_k < (n) && _fff_mpmc_read(_id, &(dst)[_v_k]); _v_k++);	\
+}while(0)
+#define REPLAY_PEEK_mpmc(_id, idx)
+#define REPLAY_REMOVE_mpmc(_id, n)										\
+do{																		\
+	typeof(_id.data[0]) _v_x;											\
+	for (size_t _v_k = 0; _v_k < (n) && _fff_mpmc_read(_id, &_v_x); _v_k++);	\
+}while(0)
+#define REPLAY_RESET_mpmc(_id)			_fff_mpmc_reset(_id)
+#define REPLAY_REBASE_mpmc(_id)
+
+
+//////////////////////////////////////////////////////////////////////////
+// Replay Cases
+//////////////////////////////////////////////////////////////////////////
+
+// replays the trace 'rounds' times; with 'obs' the fill level is observed
+typedef void (*replay_fn_t)(uint64_t rounds, replay_obs_t *obs);
+
+#define REPLAY_FIFO(V, _type, _exp)		replay_fifo_##V##_##_type##_##_exp
+#define REPLAY_FN(V, _type, _exp)		replay_##V##_##_type##_##_exp
+
+// splits an operation with the count 'cnt' into calls of at most REPLAY_CHUNK elements; 'call'
+// gets the count of each chunk as '_c_n'. The name must not collide with the locals of the fifo
+// macros used by 'call' (e.g. '_n' of _fff_write_multiple(...)).
+#define REPLAY_CHUNKS(cnt, call)										\
+do{																		\
+	for (uint32_t _c_left = (cnt), _c_n; _c_left > 0; _c_left -= _c_n)	\
+	{																	\
+		_c_n = (_c_left < REPLAY_CHUNK) ? _c_left : REPLAY_CHUNK;		\
+		call;															\
+	}																	\
+}while(0)
+
+// declares a fifo of variant 'V' with 2^_exp elements of '_type' and its replay function
+#define REPLAY_CASE(V, _type, _exp)										\
+REPLAY_DECL_##V(_type, REPLAY_FIFO(V, _type, _exp), (1ul<<_exp))		\
+																		\
+static void REPLAY_FN(V, _type, _exp)(uint64_t rounds, replay_obs_t *obs)	\
+{																		\
+	_type *_buf = (_type*)replay_buf;									\
+	for (uint64_t r = 0; r < rounds; r++)								\
+	{																	\
+		REPLAY_RESET_##V(REPLAY_FIFO(V, _type, _exp));					\
+		for (size_t k = 0; k < replay_n; k++)							\
+		{																\
+			uint32_t _cnt = FFF_TRACE_COUNT(replay_rec[k]);				\
+			size_t _level = REPLAY_LEVEL_##V(REPLAY_FIFO(V, _type, _exp));	\
+			if (obs != NULL)											\
+				replay_observe(obs, replay_rec[k].time, _level);		\
+			switch (FFF_TRACE_OP(replay_rec[k]))						\
+			{															\
+				case FFF_TRACE_WRITE:									\
+					REPLAY_CHUNKS(_cnt,									\
+						REPLAY_WRITE_##V(REPLAY_FIFO(V, _type, _exp), _buf, _c_n));	\
+					if (obs != NULL)									\
+					{													\
+						obs->offered += _cnt;							\
+						obs->drops += _level + _cnt - REPLAY_LEVEL_##V(REPLAY_FIFO(V, _type, _exp));	\
+					}													\
+					break;												\
+				case FFF_TRACE_READ:									\
+					REPLAY_CHUNKS(_cnt,									\
+						REPLAY_READ_##V(REPLAY_FIFO(V, _type, _exp), _buf, _c_n));	\
+					break;												\
+				case FFF_TRACE_PEEK:									\
+					REPLAY_PEEK_##V(REPLAY_FIFO(V, _type, _exp), _cnt);	\
+					break;												\
+				case FFF_TRACE_REMOVE:									\
+					REPLAY_REMOVE_##V(REPLAY_FIFO(V, _type, _exp), _cnt);	\
+					break;												\
+				case FFF_TRACE_RESET:									\
+					REPLAY_RESET_##V(REPLAY_FIFO(V, _type, _exp));		\
+					break;												\
+				case FFF_TRACE_REBASE:									\
+					REPLAY_REBASE_##V(REPLAY_FIFO(V, _type, _exp));		\
+					break;												\
+			}															\
+		}																\
+		BENCH_USE(_buf[0]);												\
+		BENCH_BARRIER();												\
+	}																	\
+}
+
+#define REPLAY_CASES(V, _type)											\
+	REPLAY_CASE(V, _type, 2)	REPLAY_CASE(V, _type, 3)	REPLAY_CASE(V, _type, 4)	\
+	REPLAY_CASE(V, _type, 5)	REPLAY_CASE(V, _type, 6)	REPLAY_CASE(V, _type, 7)	\
+	REPLAY_CASE(V, _type, 8)	REPLAY_CASE(V, _type, 9)	REPLAY_CASE(V, _type, 10)	\
+	REPLAY_CASE(V, _type, 11)	REPLAY_CASE(V, _type, 12)	REPLAY_CASE(V, _type, 13)	\
+	REPLAY_CASE(V, _type, 14)	REPLAY_CASE(V, _type, 15)	REPLAY_CASE(V, _type, 16)
+
+#define REPLAY_VARIANTS(_type)											\
+	REPLAY_CASES(fifo, _type)											\
+	REPLAY_CASES(overwrite, _type)										\
+	REPLAY_CASES(spsc, _type)											\
+	REPLAY_CASES(mpmc, _type)
+
+REPLAY_VARIANTS(uint8_t)
+REPLAY_VARIANTS(uint16_t)
+REPLAY_VARIANTS(uint32_t)
+REPLAY_VARIANTS(uint64_t)
+REPLAY_VARIANTS(replay_frame_t)
+
+#define REPLAY_RUNS(V, _type)											\
+	{#V, sizeof(_type), 2, REPLAY_FN(V, _type, 2)},						\
+	{#V, sizeof(_type), 3, REPLAY_FN(V, _type, 3)},						\
+	{#V, sizeof(_type), 4, REPLAY_FN(V, _type, 4)},						\
+	{#V, sizeof(_type), 5, REPLAY_FN(V, _type, 5)},						\
+	{#V, sizeof(_type), 6, REPLAY_FN(V, _type, 6)},						\
+	{#V, sizeof(_type), 7, REPLAY_FN(V, _type, 7)},						\
+	{#V, sizeof(_type), 8, REPLAY_FN(V, _type, 8)},						\
+	{#V, sizeof(_type), 9, REPLAY_FN(V, _type, 9)},						\
+	{#V, sizeof(_type), 10, REPLAY_FN(V, _type, 10)},					\
+	{#V, sizeof(_type), 11, REPLAY_FN(V, _type, 11)},					\
+	{#V, sizeof(_type), 12, REPLAY_FN(V, _type, 12)},					\
+	{#V, sizeof(_type), 13, REPLAY_FN(V, _type, 13)},					\
+	{#V, sizeof(_type), 14, REPLAY_FN(V, _type, 14)},					\
+	{#V, sizeof(_type), 15, REPLAY_FN(V, _type, 15)},					\
+	{#V, sizeof(_type), 16, REPLAY_FN(V, _type, 16)},
+
+#define REPLAY_RUNS_TYPE(_type)											\
+	REPLAY_RUNS(fifo, _type)											\
+	REPLAY_RUNS(overwrite, _type)										\
+	REPLAY_RUNS(spsc, _type)											\
+	REPLAY_RUNS(mpmc, _type)
+
+static const struct
+{
+	const char *variant;
+	size_t elem_size;
+	uint8_t exp;
+	replay_fn_t run;
+} replay_cases[] =
+{
+	REPLAY_RUNS_TYPE(uint8_t)
+	REPLAY_RUNS_TYPE(uint16_t)
+	REPLAY_RUNS_TYPE(uint32_t)
+	REPLAY_RUNS_TYPE(uint64_t)
+	REPLAY_RUNS_TYPE(replay_frame_t)
+};
+
+// replay function of the current case, called by bench_measure(...)
+static replay_fn_t replay_cur;
+
+static void replay_timed(uint64_t rounds)
+{
+	replay_cur(rounds, NULL);
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Self Check
+//////////////////////////////////////////////////////////////////////////
+
+// built-in trace; the write of 300 and the read of 400 elements are split into chunks
+static fff_trace_rec_t replay_check_rec[] =
+{
+	{1, FFF_TRACE_WRITE  | (10<<8)},
+	{1, FFF_TRACE_READ   | (3<<8)},
+	{1, FFF_TRACE_WRITE  | (300<<8)},
+	{1, FFF_TRACE_PEEK   | (2<<8)},
+	{1, FFF_TRACE_REMOVE | (5<<8)},
+	{1, FFF_TRACE_READ   | (400<<8)},
+	{1, FFF_TRACE_WRITE  | (1<<8)},
+	{1, FFF_TRACE_RESET},
+	{1, FFF_TRACE_WRITE  | (2<<8)},
+	{1, FFF_TRACE_READ   | (1<<8)},
+};
+
+// known results of replay_check_rec[] for some depths; all variants and types must match
+static const struct
+{
+	uint8_t exp;
+	uint64_t drops;
+	size_t max_level;
+} replay_check_res[] =
+{
+	{2,		303,	4},		// 10 -> 4, -3 -> 1, +300 -> 4, ...
+	{8,		51,		256},	// 10, 7, 307 -> 256, ...
+	{9,		0,		307},	// 10, 7, 307, 307 (peek), 302, 0, ...
+};
+
+// replays replay_check_rec[] with all variants and types; returns the amount of mismatches
+static int replay_check(void)
+{
+	int fails = 0;
+	replay_rec			= replay_check_rec;
+	replay_n			= sizeof(replay_check_rec)/sizeof(replay_check_rec[0]);
+	replay_ns_per_tick	= 1;
+	for (size_t k = 0; k < sizeof(replay_cases)/sizeof(replay_cases[0]); k++)
+	{
+		for (size_t i = 0; i < sizeof(replay_check_res)/sizeof(replay_check_res[0]); i++)
+		{
+			if (replay_cases[k].exp != replay_check_res[i].exp)
+				continue;
+
+			replay_obs_t obs = {replay_cases[k].variant, 1ul << replay_cases[k].exp, 0, 0, 0, 0, 0, 0, NULL, 1, 0};
+			replay_cases[k].run(1, &obs);
+			if (obs.offered != 313 || obs.drops != replay_check_res[i].drops
+				|| obs.max_level != replay_check_res[i].max_level)
+			{
+				printf("%s,%zu,%zu: offered %llu, drops %llu, max_level %zu; expected 313, %llu, %zu\n",
+					replay_cases[k].variant, replay_cases[k].elem_size, obs.depth,
+					(unsigned long long)obs.offered, (unsigned long long)obs.drops, obs.max_level,
+					(unsigned long long)replay_check_res[i].drops, replay_check_res[i].max_level);
+				fails++;
+			}
+		}
+	}
+	printf("replay check: %d mismatches\n", fails);
+	return fails;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Main
+//////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+	const char *series_path = NULL;
+	FILE *series = NULL;
+	double interval = 0;
+	double duration = 0;
+	size_t elem_size;
+	int opt;
+
+	bench_cfg.max_exp = REPLAY_EXP_MAX;
+	while ((opt = getopt(argc, argv, "t:d:f:o:i:ch")) != -1)
+	{
+		switch (opt)
+		{
+			case 't': bench_cfg.min_ns = strtoul(optarg, NULL, 0)*1000000ull; break;
+			case 'd': bench_cfg.max_exp = strtoul(optarg, NULL, 0); break;
+			case 'f': bench_cfg.filter = optarg; break;
+			case 'o': series_path = optarg; break;
+			case 'i': interval = strtod(optarg, NULL); break;
+			case 'c': return replay_check() ? 1 : 0;
+			default:
+				fprintf(stderr, "usage: %s [-t min_ms] [-d max_exp] [-f variant] [-o file] [-i ns] [-c] trace\n", argv[0]);
+				return 1;
+		}
+	}
+	if (optind != argc-1 || replay_load(argv[optind]) != 0)
+	{
+		fprintf(stderr, "usage: %s [-t min_ms] [-d max_exp] [-f variant] [-o file] [-i ns] [-c] trace\n", argv[0]);
+		return 1;
+	}
+
+	// without timestamps each record counts as 1 ns
+	for (size_t k = 0; k < replay_n; k++)
+		duration += replay_rec[k].time * replay_ns_per_tick;
+	if (duration == 0)
+	{
+		for (size_t k = 0; k < replay_n; k++)
+			replay_rec[k].time = 1;
+		replay_ns_per_tick = 1;
+		duration = replay_n;
+	}
+	if (interval <= 0)
+		interval = (duration > 1000) ? duration / 1000 : 1;
+	if (series_path != NULL)
+	{
+		series = fopen(series_path, "w");
+		if (series == NULL)
+		{
+			perror(series_path);
+			return 1;
+		}
+		fprintf(series, "variant,depth,time_ns,level\n");
+	}
+
+	// smallest element type which can hold the recorded elements
+	elem_size = sizeof(replay_frame_t);
+	for (size_t k = 0; k < sizeof(replay_cases)/sizeof(replay_cases[0]); k++)
+	{
+		if (replay_cases[k].elem_size >= replay_header.elem_size && replay_cases[k].elem_size < elem_size)
+			elem_size = replay_cases[k].elem_size;
+	}
+	if (elem_size < replay_header.elem_size)
+		fprintf(stderr, "warning: elements of %u bytes are replayed with %zu bytes\n", replay_header.elem_size, elem_size);
+	fprintf(stderr, "trace: %zu records, %.0f ns, recorded depth %u\n", replay_n, duration, replay_header.depth);
+
+	printf("variant,elem_size,depth,records,ns_per_op,offered,drops,drop_pct,max_level,mean_level,full_pct\n");
+	for (size_t k = 0; k < sizeof(replay_cases)/sizeof(replay_cases[0]); k++)
+	{
+		if (replay_cases[k].elem_size != elem_size || replay_cases[k].exp > bench_cfg.max_exp
+			|| !bench_enabled(replay_cases[k].variant))
+			continue;
+
+		size_t depth = 1ul << replay_cases[k].exp;
+		replay_obs_t obs = {replay_cases[k].variant, depth, 0, 0, 0, 0, 0, 0, series, interval, 0};
+		replay_cases[k].run(1, &obs);
+
+		uint64_t rounds;
+		replay_cur = replay_cases[k].run;
+		double ns = replay_n ? bench_measure(replay_timed, &rounds, replay_n) / replay_n : 0;
+
+		printf("%s,%zu,%zu,%zu,%.3f,%llu,%llu,%.3f,%zu,%.3f,%.3f\n", replay_cases[k].variant, elem_size,
+			depth, replay_n, ns, (unsigned long long)obs.offered, (unsigned long long)obs.drops,
+			obs.offered ? 100.0*obs.drops/obs.offered : 0, obs.max_level,
+			obs.now ? obs.level_ns/obs.now : 0, obs.now ? 100.0*obs.full_ns/obs.now : 0);
+		fflush(stdout);
+	}
+
+	if (series != NULL)
+		fclose(series);
+	free(replay_rec);
+	return 0;
+}
@@ -19,7 +19,12 @@
  *
  * If any fifo is accessed from ISRs make sure all access to the involved fifo from normal code is
  * atomic! This is important to prevent glitches in the middle of an operation!
- */ 
+ *
+ * If exactly one producer (thread or ISR) writes and exactly one consumer reads, use the lock-free
+ * variant declared by '_fff_declare_spsc(...)' instead. It needs no atomic blocks or mutexes. For
+ * many producers and a single consumer use '_fff_declare_mpsc(...)', for any number of producers
+ * and consumers use '_fff_declare_mpmc(...)'.
+ */
 
 #ifndef FIFOFAST_H_
 #define FIFOFAST_H_
@@ -39,6 +44,7 @@
 //
 // YOU DO NOT need to change the include(s) below.
 #include "utility/macros/mpl/macro_cat.h"
+#include "utility/macros/mpl/macro_vfunc.h"
 #include "utility/macros/com/macro_array.h"
 #include "utility/macros/com/macro_math.h"
 #include "utility/macros/com/macro_type.h"
@@ -60,6 +66,46 @@
 //  512 <= x		| slow
 #define FIFOFAST_MAX_DEPTH_POINTABLE	128
 
+// defines the size of a cache line in bytes. It is only used by the '_cl' fifo variants, which
+// place data written by different cores on separate cache lines. 64 bytes fits most x86 and ARM
+// Cortex-A cores; some ARM cores (e.g. Apple M1) use 128 bytes.
+#define FIFOFAST_CACHE_LINE_SIZE		64
+
+// defines the size of the scratch buffer used by _fff_rebase(...) in bytes. It is placed on the
+// stack. Larger values speed up the rebase of large fifos, but require more RAM temporarily.
+#define FIFOFAST_REBASE_SCRATCH			32
+
+// defines after how many elements the batched spsc macros (_fff_spsc_write_batch/_read_batch)
+// publish their index automatically. Larger values reduce the traffic between cores, but delay
+// the visibility of new elements (producer) or free space (consumer).
+#define FIFOFAST_SPSC_BATCH				16
+
+// defines the time source of fifos with FFF_OPT_LATENCY. Only differences are used, so any free-
+// running counter works, e.g. the TSC (x86), the virtual counter (ARMv8) or a hardware timer of an
+// MCU. For nanoseconds use a function returning CLOCK_MONOTONIC instead.
+// Other targets have no default, as no timer is known to be free. On AVR8 e.g. start timer 1 with
+// 'TCCR1B = (1<<CS10)', then define FIFOFAST_TIMESTAMP() as 'TCNT1', FIFOFAST_TIMESTAMP_AVAILABLE as
+// 1 and FIFOFAST_TIME_T as 'uint16_t'; elements stored for more than 65535 cycles wrap then.
+// Without a time source fifos with FFF_OPT_LATENCY can't be declared.
+#if defined(__x86_64__) || defined(__i386__)
+#define FIFOFAST_TIMESTAMP()			__builtin_ia32_rdtsc()
+#define FIFOFAST_TIMESTAMP_AVAILABLE	1
+#elif defined(__aarch64__)
+#define FIFOFAST_TIMESTAMP()			({uint64_t _t; __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(_t)); _t;})
+#define FIFOFAST_TIMESTAMP_AVAILABLE	1
+#else
+#define FIFOFAST_TIMESTAMP()			0
+#define FIFOFAST_TIMESTAMP_AVAILABLE	0
+#endif
+
+// defines the type of the timestamps and thus the range of the latency histogram. Each bit adds
+// 2^FIFOFAST_LATENCY_SUB_BITS buckets of 4 bytes; use uint32_t or uint16_t on MCUs.
+#define FIFOFAST_TIME_T					uint64_t
+
+// defines the precision of the latency histogram. Each power of two is split into 2^n linear
+// buckets, so the relative error is below 2^-n (n = 3: 12.5%).
+#define FIFOFAST_LATENCY_SUB_BITS		3
+
 
 //////////////////////////////////////////////////////////////////////////
 // General Info
@@ -107,6 +153,45 @@
 #define	_FFF_GET_ARRAYDEPTH(_depth)		_limit(ROUND_UP_2N(_depth), 4, ((uint32_t)1<<31))
 #define	_FFF_GET_ARRAYDEPTH_P(_depth)	_limit(ROUND_UP_2N(_depth), 4, ROUND_UP_2N(FIFOFAST_MAX_DEPTH_POINTABLE))
 
+// returns matching type for the free-running indices of spsc fifos, which count up to 2*depth-1
+#define _FFF_GET_TYPE_SPSC(_depth)		_type_min(2*_FFF_GET_ARRAYDEPTH(_depth)-1)
+
+// forces natural alignment of an index, so it can be accessed atomically even in packed structs
+#define _FFF_ALIGN_ATOMIC(_type)		__attribute__((aligned(sizeof(_type))))
+
+// places a struct member at the start of a new cache line; used by the '_cl' fifo variants
+#define _FFF_ALIGN_CL					__attribute__((aligned(FIFOFAST_CACHE_LINE_SIZE)))
+
+// declares a struct member '_name' of '_type', which only exists if '_flag' is set in '_options'.
+// Otherwise the member is an array of length 0, which uses no RAM and does not affect the alignment.
+#define _FFF_OPT_MEMBER(_options, _flag, _type, _name)					\
+	_FFF_OPT_ARRAY(_options, _flag, _type, _name, 1)
+
+// like _FFF_OPT_MEMBER(...), but declares an array of '_size' elements
+#define _FFF_OPT_ARRAY(_options, _flag, _type, _name, _size)			\
+	typeof(__builtin_choose_expr(((_options) & (_flag)) != 0, *(_type*)0, *(uint8_t*)0))	\
+		_name[((_options) & (_flag)) ? (_size) : 0]
+
+// members shared by all fifos with options. The options are stored as the size of a zero-length
+// array, so they are a compile-time constant and use no RAM. '_arraydepth' is the length of the
+// data array.
+#define _FFF_MEMBERS_OPT(_options, _arraydepth)							\
+	uint8_t options[0][(_options)+1];									\
+	_Static_assert(!((_options) & FFF_OPT_LATENCY) || FIFOFAST_TIMESTAMP_AVAILABLE,	\
+		"FFF_OPT_LATENCY needs a time source, see FIFOFAST_TIMESTAMP()");	\
+	_FFF_OPT_ARRAY(_options, FFF_OPT_LATENCY, fff_time_t, stamp, _arraydepth);	\
+	_FFF_OPT_MEMBER(_options, FFF_OPT_COUNT_DROPS, uint32_t, drops);	\
+	_FFF_OPT_MEMBER(_options, FFF_OPT_WAIT, fff_wait_t, wait)			\
+		__attribute__((aligned(((_options) & FFF_OPT_WAIT) ? 4 : 1)));		\
+	_FFF_OPT_MEMBER(_options, FFF_OPT_EVENT, fff_event_t, event)		\
+		__attribute__((aligned(((_options) & FFF_OPT_EVENT) ? 4 : 1)));		\
+	_FFF_OPT_MEMBER(_options, FFF_OPT_LATENCY, fff_latency_hist_t, latency)	\
+		__attribute__((aligned(((_options) & FFF_OPT_LATENCY) ? 4 : 1)));	\
+	_FFF_OPT_MEMBER(_options, FFF_OPT_STATS, fff_stats_t, stats)		\
+		__attribute__((aligned(((_options) & FFF_OPT_STATS) ? 4 : 1)));	\
+	_FFF_OPT_MEMBER(_options, FFF_OPT_TRACE, fff_trace_t*, trace)		\
+		__attribute__((aligned(((_options) & FFF_OPT_TRACE) ? sizeof(void*) : 1)));
+
 
 //////////////////////////////////////////////////////////////////////////
 // Data Structures (for inline functions only)
@@ -118,6 +203,103 @@
 typedef FIFOFAST_INDEX_T fff_index_t;
 typedef FIFOFAST_LEVEL_T fff_level_t;
 
+// free-running position of mpmc fifos. A thread may be interrupted for up to 2^(n-1) operations of
+// other threads before a position is mistaken, so the native pointer width is used.
+typedef uintptr_t fff_seq_t;
+typedef intptr_t fff_seq_diff_t;
+
+// describes up to two blocks of contiguous elements within the data array of any fifo. The second
+// block is only needed if the first one reaches the end of the array, otherwise 'len[1]' is 0.
+// Returned by the reserve/acquire macros.
+typedef struct
+{
+	void* ptr[2];					// first element of each block
+	size_t len[2];					// amount of elements in each block
+} fff_span_t;
+
+// state of the blocking macros in fifofast_linux.h, added to a lock-free fifo by FFF_OPT_WAIT.
+// Index 0 (FFF_WAIT_DATA) is used by consumers waiting for data, index 1 (FFF_WAIT_SPACE) by
+// producers waiting for space. The member is aligned to 4 bytes even in packed structs, as required
+// for futex words.
+typedef struct
+{
+	uint32_t seq[2];				// incremented before waking the waiting threads; futex word
+	uint32_t waiters[2];			// amount of threads which may sleep on 'seq'
+	uint32_t spin[2];				// average amount of spins before data/ space was available
+} fff_wait_t;
+
+// timestamps of fifos with FFF_OPT_LATENCY, see FIFOFAST_TIMESTAMP()
+typedef FIFOFAST_TIME_T fff_time_t;
+
+// amount of buckets of a latency histogram. Values below 2^FIFOFAST_LATENCY_SUB_BITS have their own
+// bucket, each larger power of two is split into 2^FIFOFAST_LATENCY_SUB_BITS buckets.
+#define FFF_LATENCY_BUCKETS				((8*sizeof(fff_time_t) - FIFOFAST_LATENCY_SUB_BITS + 1) << FIFOFAST_LATENCY_SUB_BITS)
+
+// log-linear histogram of the time elements were stored in a fifo, added by FFF_OPT_LATENCY
+typedef struct
+{
+	uint32_t bucket[FFF_LATENCY_BUCKETS];	// amount of elements per bucket, updated atomically
+} fff_latency_hist_t;
+
+// summary of a latency histogram returned by _fff_latency(...). Each percentile is the upper bound
+// of the bucket it falls into, so it is never lower than the exact value.
+typedef struct
+{
+	uint32_t count;					// amount of elements measured
+	fff_time_t p50;					// median
+	fff_time_t p99;
+	fff_time_t p999;
+	fff_time_t max;					// upper bound of the highest non-empty bucket
+} fff_latency_t;
+
+// counters of fifos with FFF_OPT_STATS, see _fff_stats(...). All counters are updated with relaxed
+// atomic operations, so they can be read from any thread at any time. Elements discarded by
+// _fff_reset(...) are not counted.
+typedef struct
+{
+	uint32_t written;				// amount of elements added, including those evicting older ones
+	uint32_t read;					// amount of elements removed, including evicted ones
+	uint32_t dropped;				// amount of elements dismissed (or evicted with FFF_OPT_OVERWRITE)
+	uint32_t high_water;			// highest fill level reached
+	uint32_t full;					// amount of transitions to full
+	uint32_t empty;					// amount of transitions to empty
+} fff_stats_t;
+
+// a single operation recorded by FFF_OPT_TRACE. The tuple is stored in 8 bytes, so a recorder can keep
+// many of them in RAM; see fff_trace_t.
+typedef struct
+{
+	uint32_t time;					// time since the previous record in units of FIFOFAST_TIMESTAMP(),
+									// saturated at UINT32_MAX
+	uint32_t event;					// operation (FFF_TRACE_*) in bits 0..7, count in bits 8..31
+} fff_trace_rec_t;
+
+// recorder of fifos with FFF_OPT_TRACE, attached with _fff_trace_attach(...). The records are
+// collected in the buffer 'rec'. If it is full, 'flush' is called to store them somewhere else
+// (e.g. a file or UART) and to clear 'count'; without 'flush' further records are lost.
+typedef struct fff_trace_s
+{
+	fff_trace_rec_t *rec;			// buffer of 'size' records
+	uint32_t size;
+	uint32_t count;					// amount of records in 'rec'
+	uint32_t lost;					// amount of records lost, because 'rec' was full
+	fff_time_t last;				// time of the previous record
+	void (*flush)(struct fff_trace_s *trace);	// empties 'rec', NULL: keep the first 'size' records
+	intptr_t ctx;					// free for use by 'flush', e.g. a file descriptor
+} fff_trace_t;
+
+// state of the readiness notification in fifofast_linux.h, added to a fifo by FFF_OPT_EVENT
+typedef struct
+{
+	int32_t fd;						// eventfd, valid after _fff_event_open(...)
+	uint32_t threshold;				// fill level at which the eventfd becomes readable
+	uint32_t armed;					// !0 if the next time the threshold is reached shall be signaled
+} fff_event_t;
+
+// word of the bitmap of priority queues. 'unsigned long' matches the native register width on most
+// cores and has a count-trailing-zeros builtin, see fff_pq_find(...)
+typedef unsigned long fff_pq_map_t;
+
 typedef struct
 {
 	const fff_index_t data_size;	// bytes per element in data array
@@ -148,6 +330,10 @@ static inline void		fff_remove(fff_proto_t *fifo, fff_level_t amount) __attribut
 static inline void		fff_remove_lite(fff_proto_t *fifo, fff_level_t amount) __attribute__((__always_inline__));
 static inline void		fff_write(fff_proto_t *fifo, void *data) __attribute__((__always_inline__));
 static inline void		fff_write_lite(fff_proto_t *fifo, void *data) __attribute__((__always_inline__));
+static inline fff_level_t	fff_write_multiple(fff_proto_t *fifo, const void *data, fff_level_t n) __attribute__((__always_inline__));
+static inline fff_level_t	fff_read_multiple(fff_proto_t *fifo, void *data, fff_level_t n) __attribute__((__always_inline__));
+static inline void		fff_rebase(fff_proto_t *fifo) __attribute__((__always_inline__));
+static inline fff_level_t	fff_linearize(fff_proto_t *fifo, void *data) __attribute__((__always_inline__));
 
 static inline void*		fff_peek_read(fff_proto_t *fifo, fff_index_t idx) __attribute__((__always_inline__));
 static inline void		fff_peek_write(fff_proto_t *fifo, fff_index_t idx, void *data) __attribute__((__always_inline__));
@@ -159,6 +345,17 @@ static inline void		fff_peek_write(fff_proto_t *fifo, fff_index_t idx, void *dat
 
 static inline fff_index_t fff_wrap(fff_proto_t *fifo, fff_index_t idx) __attribute__((__always_inline__));
 static inline void* fff_data_p(fff_proto_t *fifo, fff_index_t idx) __attribute__((__always_inline__));
+static inline void fff_swap_blocks(uint8_t *a, uint8_t *b, size_t n);
+static void fff_rotate(uint8_t *data, size_t n, size_t k) __attribute__((__noinline__, __unused__));
+static inline void fff_rebase_data(void *data, size_t size, size_t read, size_t level, size_t depth);
+static inline int fff_pq_find(const fff_pq_map_t *map, size_t words, size_t start);
+static inline void fff_latency_record(uint32_t *bucket, fff_time_t time);
+static inline fff_time_t fff_latency_percentile(const uint32_t *bucket, uint32_t permille);
+static inline fff_latency_t fff_latency_summary(const uint32_t *bucket);
+static inline fff_stats_t fff_stats_snapshot(const fff_stats_t *stats);
+static inline fff_stats_t fff_stats_reset(fff_stats_t *stats);
+static inline void fff_trace_init(fff_trace_t *trace, fff_trace_rec_t *rec, uint32_t size);
+static inline void fff_trace_record(fff_trace_t *trace, uint8_t op, uint32_t count);
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -167,6 +364,23 @@ static inline void* fff_data_p(fff_proto_t *fifo, fff_index_t idx) __attribute__
 
 // all function-like macros are suitable for ANY fifo, independent of data type or size. 
 
+// options of a fifo, can be combined with '|' and passed as optional last argument to
+// _fff_declare(...), _fff_declare_a(...), _fff_declare_exact(...), _fff_declare_a_exact(...) and
+// the declarations of the lock-free fifos (_fff_declare_spsc(...), ...).
+// They change the behaviour of the checked macros (_fff_write, _fff_write_multiple, _fff_add) at
+// compile time. Unused options add neither code nor RAM.
+#define FFF_OPT_NONE					0
+#define FFF_OPT_OVERWRITE				(1<<0)	// if full, the oldest element is evicted instead of dismissing the new one
+#define FFF_OPT_COUNT_DROPS				(1<<1)	// counts every dismissed or evicted element, see _fff_drops(...)
+#define FFF_OPT_WAIT					(1<<2)	// spsc/mpmc/mpsc only: adds the state for the blocking macros of fifofast_linux.h
+#define FFF_OPT_EVENT					(1<<3)	// adds an eventfd for epoll, see _fff_event_open(...) in fifofast_linux.h
+#define FFF_OPT_LATENCY					(1<<4)	// regular fifos only: measures the time each element is stored, see _fff_latency(...)
+#define FFF_OPT_STATS					(1<<5)	// regular fifos only: counts elements, high-water level and full/empty transitions, see _fff_stats(...)
+#define FFF_OPT_TRACE					(1<<6)	// regular fifos only: records every access to a recorder, see _fff_trace_attach(...)
+
+// set internally by _fff_declare_mirror(...) of fifofast_linux.h; not to be passed by the user
+#define _FFF_OPT_MIRROR					(1<<15)	// data is contiguous through the mirror, _fff_rebase(...) is a no-op
+
 // declares semi-anonymous fifofast structure
 // semi-anonymous means it appears anonymous for the user as it is derived from the '_id' whenever
 // needed, but is not anonymous on compiler level. This has the additional benefit of VAssisX and
@@ -192,13 +406,33 @@ static inline void* fff_data_p(fff_proto_t *fifo, fff_index_t idx) __attribute__
 //				   512 <= x <= 32768 | 6
 //				          x == 65536 | 8
 //				131072 <= x          | 12
-
-#define _fff_declare(_type, _id, _depth)								\
+// _options:	(optional) any combination of FFF_OPT_*, default FFF_OPT_NONE
+#define _fff_declare(...)				_VFUNC(_FFF_DECLARE_, __NARG__(__VA_ARGS__)) (__VA_ARGS__)
+#define _FFF_DECLARE_3(_type, _id, _depth)								\
+	_FFF_DECLARE(_type, _id, _FFF_GET_ARRAYDEPTH(_depth), FFF_OPT_NONE)
+#define _FFF_DECLARE_4(_type, _id, _depth, _options)					\
+	_FFF_DECLARE(_type, _id, _FFF_GET_ARRAYDEPTH(_depth), _options)
+
+// declares a fifo, which stores exactly '_depth' elements instead of the next 2^n value. This saves
+// up to 50% RAM for large fifos, but indices are wrapped with a compare and subtract instead of a
+// single AND. _fff_peek(...) requires a modulo operation, which is done by multiplication on most
+// cores. If '_depth' is 2^n anyway, the generated code is identical to _fff_declare(...).
+// All function-like macros can be used; inline functions (pointable fifos) are not supported.
+// _depth:	exact amount of elements, any value from 1 to 2^31
+// _options:	(optional) any combination of FFF_OPT_*, default FFF_OPT_NONE
+#define _fff_declare_exact(...)			_VFUNC(_FFF_DECLARE_EXACT_, __NARG__(__VA_ARGS__)) (__VA_ARGS__)
+#define _FFF_DECLARE_EXACT_3(_type, _id, _depth)						\
+	_FFF_DECLARE(_type, _id, _limit(_depth, 1, ((uint32_t)1<<31)), FFF_OPT_NONE)
+#define _FFF_DECLARE_EXACT_4(_type, _id, _depth, _options)				\
+	_FFF_DECLARE(_type, _id, _limit(_depth, 1, ((uint32_t)1<<31)), _options)
+
+#define _FFF_DECLARE(_type, _id, _arraydepth, _options)					\
 struct _FFF_NAME_STRUCT(_id) {											\
-	_FFF_GET_TYPE(_depth) read;											\
-	_FFF_GET_TYPE(_depth) write;										\
-	_FFF_GET_TYPE(_depth+1) level;										\
-	_type data[_FFF_GET_ARRAYDEPTH(_depth)];							\
+	_FFF_GET_TYPE(_arraydepth) read;									\
+	_FFF_GET_TYPE(_arraydepth) write;									\
+	_FFF_GET_TYPE(_arraydepth+1) level;									\
+	_type data[_arraydepth];											\
+	_FFF_MEMBERS_OPT(_options, _arraydepth)								\
 } _id
 
 #define _fff_declare_p(_type, _id, _depth)								\
@@ -209,11 +443,18 @@ struct _FFF_NAME_STRUCT(_id) {											\
 	fff_index_t write;													\
 	fff_level_t level;													\
 	_type data[_FFF_GET_ARRAYDEPTH_P(_depth)];							\
+	_FFF_MEMBERS_OPT(FFF_OPT_NONE, _FFF_GET_ARRAYDEPTH_P(_depth))		\
 } _id
 
 // declares an array with '_size' fifos. '_size' can be any positive integer.
-#define _fff_declare_a(_type, _id, _depth, _size)		_fff_declare(_type, _id, _depth) [_size]
+#define _fff_declare_a(...)				_VFUNC(_FFF_DECLARE_A_, __NARG__(__VA_ARGS__)) (__VA_ARGS__)
 #define _fff_declare_pa(_type, _id, _depth, _size)		_fff_declare_p(_type, , _depth) [_size]
+#define _fff_declare_a_exact(...)		_VFUNC(_FFF_DECLARE_A_EXACT_, __NARG__(__VA_ARGS__)) (__VA_ARGS__)
+
+#define _FFF_DECLARE_A_4(_type, _id, _depth, _size)					_FFF_DECLARE_3(_type, _id, _depth) [_size]
+#define _FFF_DECLARE_A_5(_type, _id, _depth, _size, _options)		_FFF_DECLARE_4(_type, _id, _depth, _options) [_size]
+#define _FFF_DECLARE_A_EXACT_4(_type, _id, _depth, _size)			_FFF_DECLARE_EXACT_3(_type, _id, _depth) [_size]
+#define _FFF_DECLARE_A_EXACT_5(_type, _id, _depth, _size, _options)	_FFF_DECLARE_EXACT_4(_type, _id, _depth, _options) [_size]
 
 
 // initializes the fifo with the name '<_id>'
@@ -226,49 +467,61 @@ struct _FFF_NAME_STRUCT(_id) {											\
 #define _fff_init(_id)													\
 struct _FFF_NAME_STRUCT(_id) _id =										\
 {																		\
-	0,																	\
-	0,																	\
-	0,																	\
-	{}																	\
+	.read	= 0,														\
+	.write	= 0,														\
+	.level	= 0,														\
+	.data	= {}														\
 }
 
 #define _fff_init_a(_id, _arraysize)									\
 struct _FFF_NAME_STRUCT(_id) _id [] =									\
 {[0 ... _arraysize-1] = {												\
-	0,																	\
-	0,																	\
-	0,																	\
-	{}																	\
+	.read	= 0,														\
+	.write	= 0,														\
+	.level	= 0,														\
+	.data	= {}														\
 }}
 
 #define _fff_init_p(_id)												\
 struct _FFF_NAME_STRUCT(_id) _id =										\
 {																		\
-	_FFF_SIZEOF_DATA(_id),												\
-	_FFF_SIZEOF_ARRAY(_id)-1,											\
-	0,																	\
-	0,																	\
-	0,																	\
-	{}																	\
+	.data_size	= _FFF_SIZEOF_DATA(_id),								\
+	.mask		= _FFF_SIZEOF_ARRAY(_id)-1,								\
+	.read		= 0,													\
+	.write		= 0,													\
+	.level		= 0,													\
+	.data		= {}													\
 }
 
 #define _fff_init_pa(_id, _arraysize)									\
 struct _FFF_NAME_STRUCT(_id) _id [] =									\
 {[0 ... _arraysize-1] = {												\
-	_FFF_SIZEOF_DATA(_id),												\
-	_FFF_SIZEOF_ARRAY(_id)-1,											\
-	0,																	\
-	0,																	\
-	0,																	\
-	{}																	\
+	.data_size	= _FFF_SIZEOF_DATA(_id),								\
+	.mask		= _FFF_SIZEOF_ARRAY(_id)-1,								\
+	.read		= 0,													\
+	.write		= 0,													\
+	.level		= 0,													\
+	.data		= {}													\
 }}
 
 
 // masks a given index value based on a given fifo
 // This macro is used to simplify other marcos below; the end user will likely never need it
+// The depth is a constant, so the compiler only keeps the AND for 2^n depths and only the compare
+// for exact depths.
 // _id:		C conform identifier
-// idx:		the index value to mask. MUST be larger than -_sizeof_array(_id.data)
-#define _fff_wrap(_id, idx)				((idx) & _fff_mem_mask(_id))
+// idx:		the index value to mask. MUST be larger than -_sizeof_array(_id.data). For fifos declared
+//			with _fff_declare_exact(...) it MUST be within 0 and 2*_sizeof_array(_id.data)-1.
+#define _fff_wrap(_id, idx)												\
+	(_is_power_of_two(_fff_mem_depth(_id))								\
+		? ((idx) & _fff_mem_mask(_id))									\
+		: ((size_t)(idx) >= _fff_mem_depth(_id) ? (size_t)(idx) - _fff_mem_depth(_id) : (size_t)(idx)))
+
+// like _fff_wrap(...), but accepts any positive index value; used for user supplied offsets
+#define _FFF_WRAP_ANY(_id, idx)											\
+	(_is_power_of_two(_fff_mem_depth(_id))								\
+		? ((idx) & _fff_mem_mask(_id))									\
+		: ((idx) % _fff_mem_depth(_id)))
 
 // returns the maximum amount of data elements which can be stored in the fifo
 // The returned value is calculated at compile time and thus a constant. No atomic access is needed.
@@ -282,6 +535,189 @@ struct _FFF_NAME_STRUCT(_id) _id [] =									\
 // _id:		C conform identifier
 #define _fff_data_size(_id)				(sizeof(_id.data[0]))
 
+// returns the options (FFF_OPT_*) the fifo has been declared with
+// The returned value is calculated at compile time and thus a constant. No atomic access is needed.
+// _id:		C conform identifier
+#define _fff_options(_id)				(sizeof(_id.options[0])-1)
+
+// returns the amount of elements dismissed by a full fifo (or evicted with FFF_OPT_OVERWRITE) since
+// the fifo was initialized. Always 0 if FFF_OPT_COUNT_DROPS is not set.
+// _id:		C conform identifier
+#define _fff_drops(_id)													\
+	((_fff_options(_id) & FFF_OPT_COUNT_DROPS) ? _id.drops[0] : 0)
+
+// adds 'n' to the drop counter, if the fifo counts drops
+#define _FFF_COUNT_DROPS(_id, n)										\
+do{																		\
+	if (_fff_options(_id) & FFF_OPT_COUNT_DROPS)						\
+		_id.drops[0] += (n);											\
+	_FFF_STATS_ADD(_id, dropped, n);									\
+}while(0)
+
+// returns a snapshot (fff_stats_t) of the counters of the fifo since it was initialized or
+// _fff_stats_reset(...) was called. Each counter is read atomically, so the snapshot can be requested
+// from any thread at any time; counters updated concurrently may be off by the pending operation.
+// Only available if FFF_OPT_STATS is set.
+// _id:		C conform identifier
+#define _fff_stats(_id)													\
+({																		\
+	_Static_assert(_fff_options(_id) & FFF_OPT_STATS, "fifo must be declared with FFF_OPT_STATS");	\
+	fff_stats_snapshot(_FFF_STATS(_id));								\
+})
+
+// like _fff_stats(...), but clears each counter atomically while reading it, so no update is lost
+// between two snapshots. The high-water level restarts at 0.
+// _id:		C conform identifier
+#define _fff_stats_reset(_id)											\
+({																		\
+	_Static_assert(_fff_options(_id) & FFF_OPT_STATS, "fifo must be declared with FFF_OPT_STATS");	\
+	fff_stats_reset(_FFF_STATS(_id));									\
+})
+
+// returns the counters; the cast keeps the code valid if the option is not set
+#define _FFF_STATS(_id)													\
+	(__builtin_choose_expr(_fff_options(_id) & FFF_OPT_STATS,			\
+		(fff_stats_t*)_id.stats, (fff_stats_t*)NULL))
+
+// adds 'n' to the counter 'field', if the fifo has statistics
+#define _FFF_STATS_ADD(_id, field, n)									\
+do{																		\
+	if (_fff_options(_id) & FFF_OPT_STATS)								\
+		__atomic_fetch_add(&_FFF_STATS(_id)->field, (n), __ATOMIC_RELAXED);	\
+}while(0)
+
+// counts 'n' added elements; must be placed after the level update. 'prev' is the level before the
+// operation, so a fifo which stays full while evicting elements is not counted as a new transition.
+#define _FFF_STATS_WRITE(_id, n, prev)									\
+do{																		\
+	if (_fff_options(_id) & FFF_OPT_STATS)								\
+	{																	\
+		fff_stats_t *_st_p = _FFF_STATS(_id);							\
+		__atomic_fetch_add(&_st_p->written, (n), __ATOMIC_RELAXED);		\
+		if (_id.level > __atomic_load_n(&_st_p->high_water, __ATOMIC_RELAXED))	\
+			__atomic_store_n(&_st_p->high_water, _id.level, __ATOMIC_RELAXED);	\
+		if (_fff_is_full(_id) && (size_t)(prev) < _fff_mem_depth(_id))	\
+			__atomic_fetch_add(&_st_p->full, 1, __ATOMIC_RELAXED);		\
+	}																	\
+}while(0)
+
+// counts 'n' removed elements; must be placed after the level update
+#define _FFF_STATS_READ(_id, n)											\
+do{																		\
+	if (_fff_options(_id) & FFF_OPT_STATS)								\
+	{																	\
+		fff_stats_t *_st_p = _FFF_STATS(_id);							\
+		__atomic_fetch_add(&_st_p->read, (n), __ATOMIC_RELAXED);		\
+		if ((n) && _fff_is_empty(_id))									\
+			__atomic_fetch_add(&_st_p->empty, 1, __ATOMIC_RELAXED);		\
+	}																	\
+}while(0)
+
+// returns a summary (fff_latency_t) of the time the elements removed from the fifo have been stored
+// since the fifo was initialized or _fff_latency_reset(...) was called. The histogram is updated
+// with atomic operations, so the summary can be requested from any thread at any time.
+// Only available if FFF_OPT_LATENCY is set. The unit is the one of FIFOFAST_TIMESTAMP().
+// _id:		C conform identifier
+#define _fff_latency(_id)												\
+({																		\
+	_Static_assert(_fff_options(_id) & FFF_OPT_LATENCY, "fifo must be declared with FFF_OPT_LATENCY");	\
+	fff_latency_summary(_FFF_LATENCY_HIST(_id));						\
+})
+
+// returns the given percentile of the time the elements have been stored, e.g. 999 for p99.9
+// _id:		C conform identifier
+// permille:	percentile in 1/1000, 0 < permille <= 1000
+#define _fff_latency_percentile(_id, permille)							\
+({																		\
+	_Static_assert(_fff_options(_id) & FFF_OPT_LATENCY, "fifo must be declared with FFF_OPT_LATENCY");	\
+	fff_latency_percentile(_FFF_LATENCY_HIST(_id), (permille));			\
+})
+
+// clears the latency histogram
+// _id:		C conform identifier
+#define _fff_latency_reset(_id)			memset(_id.latency, 0, sizeof(_id.latency))
+
+// returns the buckets of the latency histogram; the cast keeps the code valid if the option is not set
+#define _FFF_LATENCY_HIST(_id)											\
+	(__builtin_choose_expr(_fff_options(_id) & FFF_OPT_LATENCY,		\
+		(fff_latency_hist_t*)_id.latency, (fff_latency_hist_t*)NULL)->bucket)
+
+// stores the current time for 'n' elements starting at index 'idx', if the fifo measures latency
+#define _FFF_LATENCY_STAMP(_id, idx, n)									\
+do{																		\
+	if (_fff_options(_id) & FFF_OPT_LATENCY)							\
+	{																	\
+		fff_time_t _lat_now = FIFOFAST_TIMESTAMP();						\
+		for (size_t _lat_k = 0; _lat_k < (size_t)(n); _lat_k++)			\
+			_id.stamp[_fff_wrap(_id, (idx)+_lat_k)] = _lat_now;		\
+	}																	\
+}while(0)
+
+// adds the storage time of 'n' elements starting at index 'idx' to the histogram, if the fifo
+// measures latency
+#define _FFF_LATENCY_RECORD(_id, idx, n)								\
+do{																		\
+	if (_fff_options(_id) & FFF_OPT_LATENCY)							\
+	{																	\
+		fff_time_t _lat_now = FIFOFAST_TIMESTAMP();						\
+		for (size_t _lat_k = 0; _lat_k < (size_t)(n); _lat_k++)			\
+			fff_latency_record(_FFF_LATENCY_HIST(_id),					\
+				_lat_now - _id.stamp[_fff_wrap(_id, (idx)+_lat_k)]);	\
+	}																	\
+}while(0)
+
+// operations recorded by FFF_OPT_TRACE. The count is the amount of elements requested by the caller,
+// not the amount actually moved, so a trace can be replayed with any other depth or policy.
+#define FFF_TRACE_WRITE					1	// _fff_write, _fff_add, _fff_write_multiple, _fff_write_commit (+ _lite)
+#define FFF_TRACE_READ					2	// _fff_read, _fff_read_multiple (+ _lite)
+#define FFF_TRACE_PEEK					3	// _fff_peek; count is the index accessed
+#define FFF_TRACE_REMOVE				4	// _fff_remove, _fff_read_release (+ _lite)
+#define FFF_TRACE_RESET					5	// _fff_reset; count is 0
+#define FFF_TRACE_REBASE				6	// _fff_rebase; count is 0
+
+// returns the operation (FFF_TRACE_*) or the count of a record (fff_trace_rec_t)
+#define FFF_TRACE_OP(rec)				((uint8_t)((rec).event & 0xFF))
+#define FFF_TRACE_COUNT(rec)			((rec).event >> 8)
+
+// attaches a recorder (fff_trace_t), which is initialized with fff_trace_init(...) or
+// _fff_trace_open(...) of fifofast_linux.h. From now on every access of the fifo is recorded as a
+// tuple (time, operation, count) until _fff_trace_detach(...) is called. Accessing a fifo with a
+// recorder takes about 10-20 cycles longer, without a recorder 1 branch.
+// Only available if FFF_OPT_TRACE is set.
+// _id:		C conform identifier
+// trace:	variable of type fff_trace_t
+#define _fff_trace_attach(_id, trace)									\
+do{																		\
+	_Static_assert(_fff_options(_id) & FFF_OPT_TRACE, "fifo must be declared with FFF_OPT_TRACE");	\
+	(trace).last = FIFOFAST_TIMESTAMP();								\
+	*_FFF_TRACE_P(_id) = &(trace);										\
+}while(0)
+
+// stops recording; the records already collected stay in the recorder
+// _id:		C conform identifier
+#define _fff_trace_detach(_id)											\
+do{																		\
+	_Static_assert(_fff_options(_id) & FFF_OPT_TRACE, "fifo must be declared with FFF_OPT_TRACE");	\
+	*_FFF_TRACE_P(_id) = NULL;											\
+}while(0)
+
+// returns the recorder attached to the fifo, NULL if none; the cast keeps the code valid if the
+// option is not set
+#define _FFF_TRACE_P(_id)												\
+	(__builtin_choose_expr(_fff_options(_id) & FFF_OPT_TRACE,			\
+		(fff_trace_t**)_id.trace, (fff_trace_t**)NULL))
+
+// records the operation 'op' with the count 'n', if the fifo has a recorder attached
+#define _FFF_TRACE(_id, op, n)											\
+do{																		\
+	if (_fff_options(_id) & FFF_OPT_TRACE)								\
+	{																	\
+		fff_trace_t *_tr_p = *_FFF_TRACE_P(_id);						\
+		if (_tr_p != NULL)												\
+			fff_trace_record(_tr_p, (op), (n));							\
+	}																	\
+}while(0)
+
 // returns !0 if empty
 #define _fff_is_empty(_id)				(_id.level == 0)
 
@@ -298,7 +734,7 @@ struct _FFF_NAME_STRUCT(_id) _id [] =									\
 
 // clears/ resets buffer completely
 // _id:		C conform identifier
-#define _fff_reset(_id)					do{_id.read=0; _id.write=0; _id.level=0;} while (0)
+#define _fff_reset(_id)					do{_FFF_TRACE(_id, FFF_TRACE_RESET, 0); _id.read=0; _id.write=0; _id.level=0;} while (0)
 
 	
 // removes a certain number of elements or less, if not enough elements are available.
@@ -307,10 +743,11 @@ struct _FFF_NAME_STRUCT(_id) _id [] =									\
 // amount:	Amount of elements which will be removed, amount >= 0 (positive integer)
 #define _fff_remove(_id, amount)								\
 do{																\
+	_FFF_TRACE(_id, FFF_TRACE_REMOVE, amount);					\
 	typeof(_id.level) _amount = amount;							\
 	if(amount > _id.level)										\
 		_amount = _id.level;									\
-	_fff_remove_lite(_id, _amount);								\
+	_FFF_REMOVE_LITE(_id, _amount);								\
 }while(0)
 					
 // removes a certain number of elements. The user must ensure that the given amount of elements can
@@ -321,8 +758,17 @@ do{																\
 // amount:	Amount of elements which will be removed; must be 0 <= amount <= _fff_mem_level(_id);
 #define _fff_remove_lite(_id, amount)							\
 do{																\
+	_FFF_TRACE(_id, FFF_TRACE_REMOVE, amount);					\
+	_FFF_REMOVE_LITE(_id, amount);								\
+}while(0)
+
+// like _fff_remove_lite(...), but is not recorded by FFF_OPT_TRACE
+#define _FFF_REMOVE_LITE(_id, amount)							\
+do{																\
+	_FFF_LATENCY_RECORD(_id, _id.read, amount);					\
 	_id.level -= amount;										\
 	_id.read = _fff_wrap(_id, _id.read+amount);					\
+	_FFF_STATS_READ(_id, amount);								\
 }while(0)				
 
 
@@ -330,11 +776,20 @@ do{																\
 // Use if(!_fff_is_empty(_id)) if amount of stored data is unknown
 // _id: C conform identifier
 #define _fff_read_lite(_id)										\
+({																\
+	_FFF_TRACE(_id, FFF_TRACE_READ, 1);							\
+	_FFF_READ_LITE(_id);										\
+})
+
+// like _fff_read_lite(...), but is not recorded by FFF_OPT_TRACE
+#define _FFF_READ_LITE(_id)										\
 ({																\
 	typeof(_id.data[0])	_return;								\
 	_id.level--;												\
+	_FFF_LATENCY_RECORD(_id, _id.read, 1);						\
 	_return = _id.data[_id.read];								\
 	_id.read = _fff_wrap(_id, (_id.read+1));					\
+	_FFF_STATS_READ(_id, 1);									\
 	_return;													\
 })
 
@@ -344,8 +799,9 @@ do{																\
 #define _fff_read(_id)											\
 ({																\
 	typeof(_id.data[0])	_return = (typeof(_id.data[0])){0};		\
+	_FFF_TRACE(_id, FFF_TRACE_READ, 1);							\
 	if(!_fff_is_empty(_id))										\
-		_return = _fff_read_lite(_id);							\
+		_return = _FFF_READ_LITE(_id);							\
 	_return;													\
 })	
 
@@ -355,65 +811,216 @@ do{																\
 // _id:		C conform identifier
 // newdata:	data to be written
 #define _fff_write_lite(_id, newdata)							\
+do{																\
+	_FFF_TRACE(_id, FFF_TRACE_WRITE, 1);						\
+	_FFF_WRITE_LITE(_id, newdata);								\
+}while(0)
+
+// like _fff_write_lite(...), but is not recorded by FFF_OPT_TRACE
+#define _FFF_WRITE_LITE(_id, newdata)							\
 do{																\
 	_id.data[_id.write] = (newdata);							\
+	_FFF_LATENCY_STAMP(_id, _id.write, 1);						\
 	_id.write = _fff_wrap(_id, (_id.write+1));					\
 	_id.level++;												\
+	_FFF_STATS_WRITE(_id, 1, _id.level-1);						\
 }while(0)
 
 // adds an element to the fifo, if space is available
-// if full element will be dismissed
+// if full element will be dismissed. With FFF_OPT_OVERWRITE the oldest element is overwritten
+// instead, so the newest element is always stored.
 // _id:		C conform identifier
 // newdata:	data to be written
 #define _fff_write(_id, newdata)								\
 do{																\
+	_FFF_TRACE(_id, FFF_TRACE_WRITE, 1);						\
 	if(!_fff_is_full(_id))										\
-		_fff_write_lite(_id, newdata);							\
+		_FFF_WRITE_LITE(_id, newdata);							\
+	else														\
+	{															\
+		if (_fff_options(_id) & FFF_OPT_OVERWRITE)				\
+		{														\
+			/* level stays the same, read follows write */		\
+			_FFF_LATENCY_RECORD(_id, _id.write, 1);				\
+			_id.data[_id.write] = (newdata);					\
+			_FFF_LATENCY_STAMP(_id, _id.write, 1);				\
+			_id.write = _fff_wrap(_id, (_id.write+1));			\
+			_id.read = _id.write;								\
+			_FFF_STATS_ADD(_id, read, 1);						\
+			_FFF_STATS_ADD(_id, written, 1);					\
+		}														\
+		_FFF_COUNT_DROPS(_id, 1);								\
+	}															\
 }while(0)
 
 // copies an array of elements to the fifo as long as space is available
-// if full all excess elements will be dismissed
+// if full all excess elements will be dismissed. At most two memcpy() are needed (before and after
+// the end of the internal array) and the indices are updated only once.
+// With FFF_OPT_OVERWRITE the oldest elements are evicted instead, so the newest
+// min(n, _fff_mem_depth(_id)) elements are always stored.
+// Returns the amount of elements written.
 // _id:		C conform identifier
-// newdata:	array of data to be written
-// n:       amount of data do be written
+// newdata:	array of data to be written, must be of type 'typeof(_id.data[0])[]'
+// n:		amount of elements to be written
 #define _fff_write_multiple(_id, newdata, n)					\
+({																\
+	size_t _n = (n);											\
+	_FFF_TRACE(_id, FFF_TRACE_WRITE, _n);						\
+	typeof(_id.level) _prev = _id.level;						\
+	typeof(_id.level) _return = _min(_fff_mem_free(_id), _n);	\
+	const typeof(_id.data[0]) *_src = (newdata);				\
+	_FFF_COUNT_DROPS(_id, _n-_return);							\
+	if ((_fff_options(_id) & FFF_OPT_OVERWRITE) && _n > _return)	\
+	{															\
+		/* keep only the newest elements, evict the oldest */	\
+		typeof(_id.level) _evict;								\
+		_return = _min(_n, _fff_mem_depth(_id));				\
+		_src += _n - _return;									\
+		_evict = _return - _fff_mem_free(_id);					\
+		/* like _fff_remove_lite(), but the fifo never becomes empty */	\
+		_FFF_LATENCY_RECORD(_id, _id.read, _evict);				\
+		_id.level -= _evict;									\
+		_id.read = _fff_wrap(_id, _id.read+_evict);				\
+		_FFF_STATS_ADD(_id, read, _evict);						\
+	}															\
+	typeof(_id.level) _first = _min(_return, _fff_mem_depth(_id) - _id.write);	\
+	memcpy(&_id.data[_id.write], _src, _first*_fff_data_size(_id));	\
+	if (_return > _first)										\
+		memcpy(&_id.data[0], _src+_first, (_return-_first)*_fff_data_size(_id));	\
+	_FFF_LATENCY_STAMP(_id, _id.write, _return);				\
+	_id.write = _fff_wrap(_id, _id.write+_return);				\
+	_id.level += _return;										\
+	_FFF_STATS_WRITE(_id, _return, _prev);						\
+	_return;													\
+})
+
+// copies up to n elements from the fifo to an array and removes them from the fifo
+// If less than n elements are stored, all of them are read. At most two memcpy() are needed
+// (before and after the end of the internal array) and the indices are updated only once.
+// Returns the amount of elements read.
+// _id:		C conform identifier
+// dest:	array to store the data, must be of type 'typeof(_id.data[0])[]' with >= n elements
+// n:		maximum amount of elements to be read
+#define _fff_read_multiple(_id, dest, n)						\
+({																\
+	_FFF_TRACE(_id, FFF_TRACE_READ, n);							\
+	typeof(_id.level) _return = _min(_id.level, (n));			\
+	typeof(_id.level) _first = _min(_return, _fff_mem_depth(_id) - _id.read);	\
+	typeof(_id.data[0]) *_dst = (dest);							\
+	memcpy(_dst, &_id.data[_id.read], _first*_fff_data_size(_id));	\
+	if (_return > _first)										\
+		memcpy(_dst+_first, &_id.data[0], (_return-_first)*_fff_data_size(_id));	\
+	_FFF_LATENCY_RECORD(_id, _id.read, _return);				\
+	_id.read = _fff_wrap(_id, _id.read+_return);				\
+	_id.level -= _return;										\
+	_FFF_STATS_READ(_id, _return);								\
+	_return;													\
+})
+
+// returns up to two blocks of free elements, which can be filled directly (e.g. by DMA or read())
+// without copying the data. The blocks contain min(n, _fff_mem_free(_id)) elements in total. The
+// elements are not added to the fifo until _fff_write_commit(...) is called.
+// _id:		C conform identifier
+// n:		maximum amount of elements to reserve
+#define _fff_write_reserve(_id, n)								\
+({																\
+	fff_span_t _return;											\
+	size_t _amount = _min(_fff_mem_free(_id), (n));				\
+	_return.ptr[0] = &_id.data[_id.write];						\
+	_return.ptr[1] = &_id.data[0];								\
+	_return.len[0] = _min(_amount, _fff_mem_depth(_id) - _id.write);	\
+	_return.len[1] = _amount - _return.len[0];					\
+	_return;													\
+})
+
+// adds n elements to the fifo, which have been filled after _fff_write_reserve(...)
+// _id:		C conform identifier
+// n:		amount of elements to add; must not exceed the amount reserved before
+#define _fff_write_commit(_id, n)								\
 do{																\
-    typeof(_id.level) tocopy, btw;								\
-    btw = _min(_fff_mem_free(_id), (n));						\
-    if (btw == 0) {												\
-        break;													\
-    }															\
-    tocopy = _min(btw, _fff_mem_depth(_id) - _id.write);		\
-    memcpy(&_id.data[_id.write], (newdata), tocopy);			\
-    _id.level += tocopy;										\
-    _id.write = _fff_wrap(_id, (_id.write+tocopy));				\
-    btw -= tocopy;												\
-    if (btw > 0) {												\
-        memcpy(&_id.data[_id.write], (newdata)+tocopy, btw);	\
-        _id.write = btw;										\
-        _id.level += btw;										\
-    }															\
+	_FFF_TRACE(_id, FFF_TRACE_WRITE, n);						\
+	_FFF_LATENCY_STAMP(_id, _id.write, n);						\
+	_id.write = _fff_wrap(_id, _id.write+(n));					\
+	_id.level += (n);											\
+	_FFF_STATS_WRITE(_id, n, _id.level-(n));					\
 }while(0)
 
+// returns up to two blocks of stored elements, which can be accessed directly (e.g. by a parser or
+// write()) without copying the data. The blocks contain min(n, _fff_mem_level(_id)) elements in
+// total. The elements are not removed from the fifo until _fff_read_release(...) is called.
+// _id:		C conform identifier
+// n:		maximum amount of elements to acquire
+#define _fff_read_acquire(_id, n)								\
+({																\
+	fff_span_t _return;											\
+	size_t _amount = _min(_id.level, (n));						\
+	_return.ptr[0] = &_id.data[_id.read];						\
+	_return.ptr[1] = &_id.data[0];								\
+	_return.len[0] = _min(_amount, _fff_mem_depth(_id) - _id.read);	\
+	_return.len[1] = _amount - _return.len[0];					\
+	_return;													\
+})
+
+// removes n elements from the fifo after they have been processed with _fff_read_acquire(...)
+// _id:		C conform identifier
+// n:		amount of elements to remove; must not exceed the amount acquired before
+#define _fff_read_release(_id, n)		_fff_remove_lite(_id, n)
+
+// returns block '_k' (0 or 1) of a span as a pointer of the matching type for the fifo '_id'
+// _id:		C conform identifier
+// span:	span returned by one of the reserve/acquire macros
+// _k:		0 or 1
+#define _fff_span_ptr(_id, span, _k)	((typeof(&_id.data[0]))(span).ptr[_k])
+
+// returns the total amount of elements in a span
+#define _fff_span_len(span)				((span).len[0] + (span).len[1])
+
+
 // adds an element to the fifo, but does not write any data to it. instead, a pointer to the data
 // section is returned. The caller may write up to _fff_data_size(_id) bytes to this location.
 // Use if(!_fff_is_full(_id)) if amount of stored data is unknown
 // _id: C conform identifier
 #define _fff_add_lite(_id)										\
+({																\
+	_FFF_TRACE(_id, FFF_TRACE_WRITE, 1);						\
+	_FFF_ADD_LITE(_id);											\
+})
+
+// like _fff_add_lite(...), but is not recorded by FFF_OPT_TRACE
+#define _FFF_ADD_LITE(_id)										\
 ({																\
 	typeof(&_id.data[0]) _return = & _id.data[_id.write];		\
+	_FFF_LATENCY_STAMP(_id, _id.write, 1);						\
 	_id.write = _fff_wrap(_id, (_id.write+1));					\
 	_id.level++;												\
+	_FFF_STATS_WRITE(_id, 1, _id.level-1);						\
 	_return;													\
 })
 
 // like _fff_add_lite(_id), but checks if space is available before writing. Returns 'null' if full.
+// With FFF_OPT_OVERWRITE the oldest element is evicted instead, so it never returns 'null'.
 // _id: C conform identifier
 #define _fff_add(_id)											\
 ({																\
 	typeof(&_id.data[0]) _return = (typeof(&_id.data[0]))NULL;	\
+	_FFF_TRACE(_id, FFF_TRACE_WRITE, 1);						\
 	if(!_fff_is_full(_id))										\
-		_return = _fff_add_lite(_id);							\
+		_return = _FFF_ADD_LITE(_id);							\
+	else														\
+	{															\
+		if (_fff_options(_id) & FFF_OPT_OVERWRITE)				\
+		{														\
+			/* level stays the same, read follows write */		\
+			_FFF_LATENCY_RECORD(_id, _id.write, 1);				\
+			_return = &_id.data[_id.write];						\
+			_FFF_LATENCY_STAMP(_id, _id.write, 1);				\
+			_id.write = _fff_wrap(_id, (_id.write+1));			\
+			_id.read = _id.write;								\
+			_FFF_STATS_ADD(_id, read, 1);						\
+			_FFF_STATS_ADD(_id, written, 1);					\
+		}														\
+		_FFF_COUNT_DROPS(_id, 1);								\
+	}															\
 	_return;													\
 })
 
@@ -427,136 +1034,1606 @@ do{																\
 // be placed within an atomic block outside of any ISR.
 // _id:		C conform identifier
 // idx:		Offset from the first element in the buffer
-#define _fff_peek(_id, idx)				_id.data[_fff_wrap(_id, _id.read+(idx))]
+#define _fff_peek(_id, idx)										\
+	__builtin_choose_expr(_fff_options(_id) & FFF_OPT_TRACE,	\
+		(*({size_t _tr_idx = (idx); _FFF_TRACE(_id, FFF_TRACE_PEEK, _tr_idx);	\
+			&_id.data[_FFF_WRAP_ANY(_id, _id.read+_tr_idx)];})),	\
+		_id.data[_FFF_WRAP_ANY(_id, _id.read+(idx))])
 
 
 // re-writes the internal array, so that the element _fff_peek(0) will be at the physical idx 0
 // Although this does not effect any of the fifo functions, it does simplify operations on string
 // stored in the fifo.
-// NOTE that this macro copies element-by-element and might take very long for large fifos with many
-// elements or large data sizes.
-//
-// Macro inspired by Jon Bentley's array rotation algorithm and this stackoverflow answer:
-// https://stackoverflow.com/a/22079960/6215916
-//
-// This version has only one call of _FFF_REVERSE to safe program memory
+// Only the stored elements are moved, the free part of the array is ignored. If the data does not
+// wrap around the end of the array a single memmove() is sufficient. Otherwise the smaller part is
+// parked in a scratch buffer of FIFOFAST_REBASE_SCRATCH bytes on the stack, or, if it is too
+// large, the elements are rotated with block swaps (Gries-Mills), which moves every byte at most
+// twice in chunks of FIFOFAST_REBASE_SCRATCH bytes. Consider _fff_linearize(...) if the data is
+// only required in a separate buffer anyway.
+// This macro is NOT ATOMIC. If fifo "_id" is accessed within an ISR at least once, this macro MUST
+// be placed within an atomic block outside of any ISR.
+// _id:		C conform identifier
 #define _fff_rebase(_id)										\
 do{																\
+	_FFF_TRACE(_id, FFF_TRACE_REBASE, 0);						\
 	/* check if rebase required */								\
-	if (_id.read == 0)											\
+	if (_id.read == 0 || (_fff_options(_id) & _FFF_OPT_MIRROR))	\
 		break;													\
 																\
-	typeof(_id.read) idx1, idx2;								\
-																\
-	/* reversing 1st half, 2nd half and everything together	*/	\
-	/* rotates the array									*/	\
-	for (uint8_t rep = 0; rep<3; rep++)							\
-	{															\
-		switch (rep)											\
-		{														\
-			default:											\
-			case 0:												\
-				idx1 = 0;										\
-				idx2 = _id.read-1;								\
-				break;											\
-			case 1:												\
-				idx1 = _id.read;								\
-				idx2 = _fff_mem_mask(_id);						\
-				break;											\
-			case 2:												\
-				idx1 = 0;										\
-				idx2 = _fff_mem_mask(_id);						\
-				break;											\
-		}														\
-																\
-		/* reverse section from idx1 to idx2 */					\
-		for (; idx1 < idx2; idx1++, idx2--)						\
-		{														\
-			typeof(_id.data[0]) tmp;							\
-			tmp				= _id.data[idx1];					\
-			_id.data[idx1]	= _id.data[idx2];					\
-			_id.data[idx2]	= tmp;								\
-		}														\
-	}															\
+	fff_rebase_data(_id.data, _fff_data_size(_id), _id.read, _id.level, _fff_mem_depth(_id));	\
+	if (_fff_options(_id) & FFF_OPT_LATENCY)					\
+		fff_rebase_data(_id.stamp, sizeof(fff_time_t), _id.read, _id.level, _fff_mem_depth(_id));	\
 																\
 	/* Update data indices */									\
-	_id.write	= _id.write - _id.read;							\
 	_id.read	= 0;											\
+	_id.write	= _fff_wrap(_id, _id.level);					\
 }while(0)
 
+// copies all stored elements in order to 'dest' without removing them from the fifo and returns
+// the amount of elements copied. 'dest' must provide space for _fff_mem_depth(_id) elements.
+// Use instead of _fff_rebase(...) if the fifo itself does not need to be linear.
+// _id:		C conform identifier
+// dest:	pointer to the destination array
+#define _fff_linearize(_id, dest)								\
+({																\
+	typeof(_id.level) _return = _id.level;						\
+	typeof(_id.level) _first = _min(_return, _fff_mem_depth(_id) - _id.read);	\
+	typeof(_id.data[0]) *_dst = (dest);							\
+	memcpy(_dst, &_id.data[_id.read], _first*_fff_data_size(_id));	\
+	if (_return > _first)										\
+		memcpy(_dst+_first, &_id.data[0], (_return-_first)*_fff_data_size(_id));	\
+	_return;													\
+})
+
+
 //////////////////////////////////////////////////////////////////////////
-// Inline functions
+// variable-length record macros (_fff_record_*)
 //////////////////////////////////////////////////////////////////////////
 
-// Inline functions MUST be defined in the .h, not in the .c file to work correctly!
+// A record fifo stores messages of different length (e.g. serial frames) in a byte array. Each
+// record consists of a length prefix followed by the payload. The prefix has the type of the
+// indices, so it takes 1 byte for depths up to 256 and 2 bytes up to 65536.
+// A record is never split at the end of the array, so its payload can always be accessed directly
+// with _fff_record_peek(...). If a record does not fit before the end, the remaining bytes are
+// marked as unused with a prefix of 0 (if there is enough space for it) and the record is stored
+// at the start of the array. Thus records of 0 bytes can't be stored.
+// The regular macros _fff_mem_level, _fff_mem_free, _fff_is_empty and _fff_reset can be used and
+// count bytes, not records.
+//
+// _id:		C conform identifier
+// _depth:	size of the byte array, see _fff_declare(...). The largest record which can be stored is
+//			_depth - sizeof(prefix) bytes.
+#define _fff_declare_record(_id, _depth)								\
+	_FFF_DECLARE(uint8_t, _id, _FFF_GET_ARRAYDEPTH(_depth), FFF_OPT_NONE)
 
-// auxiliary functions
-static inline fff_index_t fff_wrap(fff_proto_t *fifo, fff_index_t idx)
-{
-	return (idx & fifo->mask);
-}
-static inline void* fff_data_p(fff_proto_t *fifo, fff_index_t idx)
-{
-	return &(fifo->data[idx * fifo->data_size]);
-}
-static inline fff_index_t fff_mem_mask(fff_proto_t *fifo)
-{
-	return (fifo->mask);
-}
-static inline fff_index_t fff_data_size(fff_proto_t *fifo)
-{
-	return fifo->data_size;
-}
+#define _fff_init_record(_id)			_fff_init(_id)
 
-//
-static inline uint8_t fff_is_empty(fff_proto_t *fifo)
-{
-	return (fifo->level == 0);
-}
-static inline uint8_t fff_is_full(fff_proto_t *fifo)
-{
-	return (fifo->level > fifo->mask);
-}
-static inline fff_level_t fff_mem_level(fff_proto_t *fifo)
-{
-	return (fifo->level);
-}
-static inline fff_index_t fff_mem_free(fff_proto_t *fifo)
-{
-	return (fifo->mask - fifo->level + 1);
-}
+// returns the size of the length prefix in bytes
+#define _FFF_RECORD_PREFIX(_id)			sizeof(_id.read)
+
+// adds a record to the fifo, if space is available
+// if full the record will be dismissed. Returns !0 if the record was written.
+// _id:		C conform identifier
+// ptr:		pointer to the payload
+// len:		length of the payload in bytes, 1 ... _depth - sizeof(prefix)
+#define _fff_record_write(_id, ptr, len)								\
+({																		\
+	uint8_t _return = 0;												\
+	size_t _len = (len);												\
+	size_t _need = _FFF_RECORD_PREFIX(_id) + _len;						\
+	size_t _room = _fff_mem_depth(_id) - _FFF_RECORD_PREFIX(_id);		\
+	/* an empty fifo can start at 0 again, so the whole array is usable */	\
+	if (_id.level == 0)													\
+		_id.read = _id.write = 0;										\
+	size_t _tail = _fff_mem_depth(_id) - _id.write;						\
+	size_t _skip = (_need > _tail) ? _tail : 0;							\
+	if (_len > 0 && _len <= _room && _skip + _need <= _fff_mem_free(_id))	\
+	{																	\
+		typeof(_id.read) _prefix = 0;									\
+		if (_skip)														\
+		{																\
+			if (_tail >= _FFF_RECORD_PREFIX(_id))						\
+				memcpy(&_id.data[_id.write], &_prefix, _FFF_RECORD_PREFIX(_id));	\
+			_id.write = 0;												\
+			_id.level += _skip;											\
+		}																\
+		_prefix = _len;													\
+		memcpy(&_id.data[_id.write], &_prefix, _FFF_RECORD_PREFIX(_id));	\
+		/* _len <= _room already, the clamp makes it visible to -Wstringop-overflow at -O0 */	\
+		uint8_t *_payload = &_id.data[_id.write + _FFF_RECORD_PREFIX(_id)];	\
+		memcpy(_payload, (ptr), _min(_len, _room));						\
+		_id.write = _fff_wrap(_id, _id.write + _need);					\
+		_id.level += _need;												\
+		_return = 1;													\
+	}																	\
+	_return;															\
+})
+
+// returns the payload length of the next record in bytes, 0 if the fifo is empty
+// Unused bytes at the end of the array are removed if necessary.
+// _id:		C conform identifier
+#define _fff_record_len(_id)											\
+({																		\
+	typeof(_id.read) _return = 0;										\
+	if (_id.level)														\
+	{																	\
+		size_t _tail = _fff_mem_depth(_id) - _id.read;					\
+		if (_tail >= _FFF_RECORD_PREFIX(_id))							\
+			memcpy(&_return, &_id.data[_id.read], _FFF_RECORD_PREFIX(_id));	\
+		if (_return == 0)												\
+		{																\
+			/* skip unused bytes, the record continues at the start */	\
+			_id.level -= _tail;											\
+			_id.read = 0;												\
+			memcpy(&_return, &_id.data[0], _FFF_RECORD_PREFIX(_id));	\
+		}																\
+	}																	\
+	_return;															\
+})
+
+// returns a pointer to the payload of the next record without removing it, NULL if empty
+// The payload is always contiguous. Use _fff_record_len(...) to get its length.
+// _id:		C conform identifier
+#define _fff_record_peek(_id)											\
+({																		\
+	uint8_t *_return = NULL;											\
+	if (_fff_record_len(_id))											\
+		_return = &_id.data[_id.read + _FFF_RECORD_PREFIX(_id)];		\
+	_return;															\
+})
+
+// removes the next record, if any
+// _id:		C conform identifier
+#define _fff_record_remove(_id)											\
+do{																		\
+	size_t _need = _fff_record_len(_id);								\
+	if (_need)															\
+	{																	\
+		_need += _FFF_RECORD_PREFIX(_id);								\
+		_id.read = _fff_wrap(_id, _id.read + _need);					\
+		_id.level -= _need;												\
+	}																	\
+}while(0)
+
+// copies the payload of the next record to 'dest' and removes the record from the fifo
+// If the record is longer than 'maxlen', only 'maxlen' bytes are copied, but the whole record is
+// removed. Returns the payload length of the record, 0 if the fifo was empty.
+// _id:		C conform identifier
+// dest:	pointer to the destination
+// maxlen:	size of the destination in bytes
+#define _fff_record_read(_id, dest, maxlen)								\
+({																		\
+	size_t _return = _fff_record_len(_id);								\
+	if (_return)														\
+	{																	\
+		memcpy((dest), &_id.data[_id.read + _FFF_RECORD_PREFIX(_id)], _min(_return, (size_t)(maxlen)));	\
+		_id.read = _fff_wrap(_id, _id.read + _FFF_RECORD_PREFIX(_id) + _return);	\
+		_id.level -= _FFF_RECORD_PREFIX(_id) + _return;					\
+	}																	\
+	_return;															\
+})
+
+
+//////////////////////////////////////////////////////////////////////////
+// bi-partite buffer macros (_fff_bip_*)
+//////////////////////////////////////////////////////////////////////////
 
+// A bip buffer hands out contiguous blocks only, so parsers and DMA never have to handle a wrap.
+// The stored data is kept in up to two regions: region A ('a_start' to 'a_end') is read first,
+// region B (0 to 'b_end') is created once the space behind A is too small and is read after A.
+// Space is reserved with _fff_bip_write_reserve(...), filled and added with
+// _fff_bip_write_commit(...). The stored data is accessed with _fff_bip_read_acquire(...) and
+// removed with _fff_bip_read_release(...). Both return a fff_span_t with a single block ('len[1]'
+// is always 0), so the same code can handle regular and bip fifos.
+// Use uint8_t as '_type' for raw bytes. The depth is not rounded up.
+// Like the regular fifos, the bip macros are NOT ATOMIC.
 //
-static inline void fff_reset(fff_proto_t *fifo)
-{
-	fifo->read	= 0;
-	fifo->write	= 0;
-	fifo->level = 0;
+// _id:		C conform identifier
+// _type:	any C type except pointers and structs. To store pointers or structs use typedef first
+// _depth:	exact amount of elements, any value from 1 to 2^31
+#define _fff_declare_bip(_type, _id, _depth)							\
+struct _FFF_NAME_STRUCT(_id) {											\
+	_FFF_GET_TYPE(_depth+1) a_start;									\
+	_FFF_GET_TYPE(_depth+1) a_end;										\
+	_FFF_GET_TYPE(_depth+1) b_end;										\
+	_FFF_GET_TYPE(_depth+1) res_start;									\
+	_FFF_GET_TYPE(_depth+1) res_len;									\
+	_type data[_limit(_depth, 1, ((uint32_t)1<<31))];					\
+} _id
+
+#define _fff_init_bip(_id)												\
+struct _FFF_NAME_STRUCT(_id) _id =										\
+{																		\
+	0,																	\
+	0,																	\
+	0,																	\
+	0,																	\
+	0,																	\
+	{}																	\
 }
 
+// once region A is empty, region B becomes the new region A. If both are empty and no space is
+// reserved, A restarts at index 0 to make the whole array available.
+#define _FFF_BIP_NORMALIZE(_id)											\
+do{																		\
+	if (_id.a_start == _id.a_end)										\
+	{																	\
+		if (_id.b_end)													\
+		{																\
+			_id.a_start = 0;											\
+			_id.a_end = _id.b_end;										\
+			_id.b_end = 0;												\
+		}																\
+		else if (_id.res_len == 0)										\
+		{																\
+			_id.a_start = 0;											\
+			_id.a_end = 0;												\
+		}																\
+	}																	\
+}while(0)
 
-static inline void fff_remove(fff_proto_t *fifo, fff_level_t amount)
-{
-	if (amount > fifo->level)
-		amount = fifo->level;
-	fff_remove_lite(fifo, amount);
-}
-static inline void fff_remove_lite(fff_proto_t *fifo, fff_level_t amount)
-{
-	fifo->level -= amount;
-	fifo->read = fff_wrap(fifo, fifo->read + amount);
-}
+// returns the amount of stored elements in both regions
+// _id: C conform identifier
+#define _fff_bip_mem_level(_id)			((_id.a_end - _id.a_start) + _id.b_end)
 
-static inline void fff_write(fff_proto_t *fifo, void *data)
-{
-	if (!fff_is_full(fifo))
-	fff_write_lite(fifo,data);
-}
-static inline void fff_write_lite(fff_proto_t *fifo, void *data)
-{
-	memcpy(fff_data_p(fifo, fifo->write), data, fifo->data_size);
-	fifo->write = fff_wrap(fifo, fifo->write+1);
-	fifo->level++;
+// returns !0 if empty
+#define _fff_bip_is_empty(_id)			(_fff_bip_mem_level(_id) == 0)
+
+// clears/ resets buffer completely, including any reservation
+// _id:		C conform identifier
+#define _fff_bip_reset(_id)												\
+	do{_id.a_start=0; _id.a_end=0; _id.b_end=0; _id.res_start=0; _id.res_len=0;} while (0)
+
+// reserves the largest contiguous block of free elements up to n elements and returns it. If n
+// elements fit behind region A they are reserved there, otherwise the larger block (behind A or in
+// front of it) is chosen; on a tie the block behind A. 'len[0]' is 0 if no space is available.
+// Only one reservation can exist; a new call replaces the previous one.
+// _id:		C conform identifier
+// n:		maximum amount of elements to reserve
+#define _fff_bip_write_reserve(_id, n)									\
+({																		\
+	fff_span_t _return;													\
+	size_t _n = (n);													\
+	size_t _start, _free;												\
+	_id.res_len = 0;													\
+	_FFF_BIP_NORMALIZE(_id);											\
+	if (_id.b_end)														\
+	{																	\
+		_start = _id.b_end;												\
+		_free = _id.a_start - _id.b_end;								\
+	}																	\
+	else if (_fff_mem_depth(_id) - _id.a_end >= _min(_n, (size_t)_id.a_start))		\
+	{																	\
+		_start = _id.a_end;												\
+		_free = _fff_mem_depth(_id) - _id.a_end;						\
+	}																	\
+	else																\
+	{																	\
+		_start = 0;														\
+		_free = _id.a_start;											\
+	}																	\
+	_id.res_start = _start;												\
+	_id.res_len = _min(_free, _n);										\
+	_return.ptr[0] = &_id.data[_start];									\
+	_return.ptr[1] = &_id.data[0];										\
+	_return.len[0] = _id.res_len;										\
+	_return.len[1] = 0;													\
+	_return;															\
+})
+
+// adds n elements, which have been filled after _fff_bip_write_reserve(...), and ends the
+// reservation
+// _id:		C conform identifier
+// n:		amount of elements to add; values larger than the reservation are limited
+#define _fff_bip_write_commit(_id, n)									\
+do{																		\
+	typeof(_id.res_len) _n = _min((size_t)(n), (size_t)_id.res_len);	\
+	if (_n && (_id.b_end || _id.res_start != _id.a_end))				\
+		_id.b_end = _id.res_start + _n;									\
+	else																\
+		_id.a_end += _n;												\
+	_id.res_len = 0;													\
+	_FFF_BIP_NORMALIZE(_id);											\
+}while(0)
+
+// returns the block of elements to be read next. It is always contiguous. 'len[0]' is 0 if empty.
+// The elements are not removed until _fff_bip_read_release(...) is called.
+// _id:		C conform identifier
+#define _fff_bip_read_acquire(_id)										\
+({																		\
+	fff_span_t _return;													\
+	_FFF_BIP_NORMALIZE(_id);											\
+	_return.ptr[0] = &_id.data[_id.a_start];							\
+	_return.ptr[1] = &_id.data[0];										\
+	_return.len[0] = _id.a_end - _id.a_start;							\
+	_return.len[1] = 0;													\
+	_return;															\
+})
+
+// removes n elements after they have been processed with _fff_bip_read_acquire(...)
+// _id:		C conform identifier
+// n:		amount of elements to remove; values larger than the acquired block are limited
+#define _fff_bip_read_release(_id, n)									\
+do{																		\
+	_id.a_start += _min((size_t)(n), (size_t)(_id.a_end - _id.a_start));	\
+	_FFF_BIP_NORMALIZE(_id);											\
+}while(0)
+
+
+//////////////////////////////////////////////////////////////////////////
+// priority queue macros (_fff_pq_*)
+//////////////////////////////////////////////////////////////////////////
+
+// A priority queue is an array of '_levels' fifos plus a bitmap of all non-empty fifos. Level 0 has
+// the highest priority. The bitmap is updated by the _fff_pq_* macros, so the next fifo to read is
+// found with a single count-trailing-zeros instruction per bitmap word, independent of the number of
+// stored elements.
+// The fifo of each level can be accessed directly as '_id.q[prio]' with all function-like macros
+// (_fff_peek, _fff_mem_level, ...). If elements are added or removed this way, call
+// _fff_pq_update(...) afterwards.
+// Like the regular fifos, the pq macros are NOT ATOMIC.
+//
+// _id:		C conform identifier
+// _type:	any C type except pointers and structs. To store pointers or structs use typedef first
+// _depth:	maximum amount of elements per level, see _fff_declare(...)
+// _levels:	amount of priority levels, any positive integer
+#define _fff_declare_pq(_type, _id, _depth, _levels)					\
+struct _FFF_NAME_STRUCT(_id) {											\
+	fff_pq_map_t map[_FFF_PQ_WORDS(_levels)] _FFF_ALIGN_ATOMIC(fff_pq_map_t);	\
+	_FFF_GET_TYPE(_levels) cursor;										\
+	uint8_t credit;														\
+	uint8_t weight[_levels];											\
+	struct {															\
+		_FFF_GET_TYPE(_FFF_GET_ARRAYDEPTH(_depth)) read;				\
+		_FFF_GET_TYPE(_FFF_GET_ARRAYDEPTH(_depth)) write;				\
+		_FFF_GET_TYPE(_FFF_GET_ARRAYDEPTH(_depth)+1) level;			\
+		_type data[_FFF_GET_ARRAYDEPTH(_depth)];						\
+		_FFF_MEMBERS_OPT(FFF_OPT_NONE, _FFF_GET_ARRAYDEPTH(_depth))		\
+	} q[_levels];														\
+} _id
+
+// all weights for _fff_pq_read_wrr(...) are initialized to 1. The cursor starts at the last level,
+// so the first turn goes to level 0.
+#define _fff_init_pq(_id)												\
+struct _FFF_NAME_STRUCT(_id) _id =										\
+{																		\
+	{},																	\
+	_FFF_PQ_LEVELS(_id)-1,												\
+	0,																	\
+	{[0 ... _FFF_PQ_LEVELS(_id)-1] = 1},								\
+	{}																	\
+}
+
+#define _FFF_PQ_BITS					(8*sizeof(fff_pq_map_t))
+#define _FFF_PQ_WORDS(_levels)			(((_levels)+_FFF_PQ_BITS-1)/_FFF_PQ_BITS)
+#define _FFF_PQ_LEVELS(_id)				_sizeof_array(((struct _FFF_NAME_STRUCT(_id)*)0)->q)
+#define _FFF_PQ_BIT(_prio)				((fff_pq_map_t)1 << ((_prio) % _FFF_PQ_BITS))
+
+// reads the next element of level '_prio' to '*(data_p)' and clears its bit once the level is empty
+#define _FFF_PQ_READ(_id, _prio, data_p)								\
+do{																		\
+	*(data_p) = _fff_read_lite(_id.q[_prio]);							\
+	if (_fff_is_empty(_id.q[_prio]))									\
+		_id.map[(_prio) / _FFF_PQ_BITS] &= ~_FFF_PQ_BIT(_prio);		\
+}while(0)
+
+// returns the amount of priority levels
+// _id:		C conform identifier
+#define _fff_pq_levels(_id)				_sizeof_array(_id.q)
+
+// returns !0 if all levels are empty
+// _id:		C conform identifier
+#define _fff_pq_is_empty(_id)			(fff_pq_find(_id.map, _sizeof_array(_id.map), 0) < 0)
+
+// returns the highest priority (lowest level) with at least one element or -1 if all are empty
+// _id:		C conform identifier
+#define _fff_pq_highest(_id)			fff_pq_find(_id.map, _sizeof_array(_id.map), 0)
+
+// clears/ resets all levels and the round-robin state. The weights are kept.
+// _id:		C conform identifier
+#define _fff_pq_reset(_id)												\
+do{																		\
+	for (size_t _pq_k = 0; _pq_k < _fff_pq_levels(_id); _pq_k++)		\
+		_fff_reset(_id.q[_pq_k]);										\
+	memset(_id.map, 0, sizeof(_id.map));								\
+	_id.cursor = _fff_pq_levels(_id)-1;									\
+	_id.credit = 0;														\
+}while(0)
+
+// updates the bitmap entry of level 'prio' after its fifo '_id.q[prio]' was modified directly
+// _id:		C conform identifier
+// prio:	priority level, 0 <= prio < _fff_pq_levels(_id)
+#define _fff_pq_update(_id, prio)										\
+do{																		\
+	size_t _pq_prio = (prio);											\
+	if (_fff_is_empty(_id.q[_pq_prio]))									\
+		_id.map[_pq_prio / _FFF_PQ_BITS] &= ~_FFF_PQ_BIT(_pq_prio);		\
+	else																\
+		_id.map[_pq_prio / _FFF_PQ_BITS] |= _FFF_PQ_BIT(_pq_prio);		\
+}while(0)
+
+// adds an element to the fifo of level 'prio', see _fff_write(...)
+// _id:		C conform identifier
+// prio:	priority level, 0 <= prio < _fff_pq_levels(_id); 0 is the highest priority
+// newdata:	data to be written
+#define _fff_pq_write(_id, prio, newdata)								\
+do{																		\
+	size_t _pq_prio = (prio);											\
+	_fff_write(_id.q[_pq_prio], newdata);								\
+	_id.map[_pq_prio / _FFF_PQ_BITS] |= _FFF_PQ_BIT(_pq_prio);			\
+}while(0)
+
+// moves the next element of the highest non-empty priority level to '*(data_p)'
+// Returns the level the element was read from or -1 if all levels are empty ('*(data_p)' unchanged).
+// _id:		C conform identifier
+// data_p:	pointer to a variable of the fifo's data type
+#define _fff_pq_read_highest(_id, data_p)								\
+({																		\
+	int _pq_return = _fff_pq_highest(_id);								\
+	if (_pq_return >= 0)												\
+		_FFF_PQ_READ(_id, _pq_return, data_p);							\
+	_pq_return;															\
+})
+
+// moves the next element to '*(data_p)' using weighted round-robin: the non-empty levels are served
+// in ascending order, each for up to '_id.weight[prio]' consecutive elements before moving on to the
+// next non-empty level. Empty levels are skipped without losing a turn. A weight of 0 counts as 1.
+// The weights can be changed at any time; the change applies on the next turn of that level.
+// Returns the level the element was read from or -1 if all levels are empty ('*(data_p)' unchanged).
+// _id:		C conform identifier
+// data_p:	pointer to a variable of the fifo's data type
+#define _fff_pq_read_wrr(_id, data_p)									\
+({																		\
+	int _pq_return = _id.cursor;										\
+	if (_id.credit == 0 || !(_id.map[_pq_return / _FFF_PQ_BITS] & _FFF_PQ_BIT(_pq_return)))	\
+	{																	\
+		_pq_return = fff_pq_find(_id.map, _sizeof_array(_id.map),		\
+			_pq_return + (_id.credit == 0));							\
+		if (_pq_return >= 0)											\
+		{																\
+			_id.cursor = _pq_return;									\
+			_id.credit = _id.weight[_pq_return] ? _id.weight[_pq_return] : 1;	\
+		}																\
+	}																	\
+	if (_pq_return >= 0)												\
+	{																	\
+		_id.credit--;													\
+		_FFF_PQ_READ(_id, _pq_return, data_p);							\
+	}																	\
+	_pq_return;															\
+})
+
+
+//////////////////////////////////////////////////////////////////////////
+// structure-of-arrays fifo array macros (_fff_soa_*)
+//////////////////////////////////////////////////////////////////////////
+
+// An array of fifos as declared by _fff_declare_a(...) stores the indices of each fifo next to its
+// data, so a sweep over the fill levels of many fifos touches one cache line per fifo. A soa fifo
+// array keeps all indices in three separate arrays instead ('read[]', 'write[]', 'level[]') and all
+// data in a separate two-dimensional array. Scanning the fill levels or resetting all fifos accesses
+// only 3*'_size' bytes for fifos of up to 128 elements, and the loops can be vectorized.
+// Each fifo is addressed by its position 'fifo' within the array. The macros have the same behaviour
+// as their regular counterparts. '_id.level[fifo]' may be read directly.
+// Like the regular fifos, the soa macros are NOT ATOMIC.
+//
+// _id:		C conform identifier
+// _type:	any C type except pointers and structs. To store pointers or structs use typedef first
+// _depth:	maximum amount of elements per fifo, see _fff_declare(...)
+// _size:	amount of fifos, any positive integer
+#define _fff_declare_soa(_type, _id, _depth, _size)						\
+struct _FFF_NAME_STRUCT(_id) {											\
+	_FFF_GET_TYPE(_FFF_GET_ARRAYDEPTH(_depth)) read[_size];				\
+	_FFF_GET_TYPE(_FFF_GET_ARRAYDEPTH(_depth)) write[_size];			\
+	_FFF_GET_TYPE(_FFF_GET_ARRAYDEPTH(_depth)+1) level[_size];			\
+	_type data[_size][_FFF_GET_ARRAYDEPTH(_depth)];						\
+} _id
+
+// all members are 0, so the soa fifo array is placed in .bss and needs no initialization data
+#define _fff_init_soa(_id)												\
+struct _FFF_NAME_STRUCT(_id) _id =										\
+{																		\
+	{},																	\
+	{},																	\
+	{},																	\
+	{}																	\
+}
+
+// returns the amount of fifos in the array
+// The returned value is calculated at compile time and thus a constant.
+// _id:		C conform identifier
+#define _fff_soa_size(_id)				(_sizeof_array(_id.level))
+
+// returns the maximum amount of elements which can be stored in each fifo
+// The returned value is calculated at compile time and thus a constant.
+// _id:		C conform identifier
+#define _fff_soa_mem_depth(_id)			(_sizeof_array(_id.data[0]))
+#define _fff_soa_mem_mask(_id)			(_sizeof_array(_id.data[0])-1)
+
+// returns the current fill level/ free space of a fifo
+// _id:		C conform identifier
+// fifo:	position of the fifo within the array, 0 <= fifo < _fff_soa_size(_id)
+#define _fff_soa_mem_level(_id, fifo)	(_id.level[fifo])
+#define _fff_soa_mem_free(_id, fifo)	(_fff_soa_mem_depth(_id) - _id.level[fifo])
+
+// returns !0 if the fifo is empty/ full
+#define _fff_soa_is_empty(_id, fifo)	(_id.level[fifo] == 0)
+#define _fff_soa_is_full(_id, fifo)		(_id.level[fifo] > _fff_soa_mem_mask(_id))
+
+// clears/ resets a single fifo
+// _id:		C conform identifier
+// fifo:	position of the fifo within the array, 0 <= fifo < _fff_soa_size(_id)
+#define _fff_soa_reset(_id, fifo)										\
+do{																		\
+	size_t _soa_n = (fifo);												\
+	_id.read[_soa_n] = 0;												\
+	_id.write[_soa_n] = 0;												\
+	_id.level[_soa_n] = 0;												\
+}while(0)
+
+// clears/ resets all fifos of the array. Only the index arrays are written.
+// _id:		C conform identifier
+#define _fff_soa_reset_all(_id)											\
+do{																		\
+	memset(_id.read, 0, sizeof(_id.read));								\
+	memset(_id.write, 0, sizeof(_id.write));							\
+	memset(_id.level, 0, sizeof(_id.level));							\
+}while(0)
+
+// returns the amount of non-empty fifos in the array. Only the 'level' array is read.
+// _id:		C conform identifier
+#define _fff_soa_count_nonempty(_id)									\
+({																		\
+	size_t _soa_return = 0;												\
+	for (size_t _soa_k = 0; _soa_k < _fff_soa_size(_id); _soa_k++)		\
+		_soa_return += (_id.level[_soa_k] != 0);						\
+	_soa_return;														\
+})
+
+// returns the position of the first non-empty fifo at or after 'start' or _fff_soa_size(_id), if
+// all remaining fifos are empty. Only the 'level' array is read.
+// _id:		C conform identifier
+// start:	position of the first fifo to check
+#define _fff_soa_find_nonempty(_id, start)								\
+({																		\
+	size_t _soa_return = (start);										\
+	while (_soa_return < _fff_soa_size(_id) && _id.level[_soa_return] == 0)	\
+		_soa_return++;													\
+	_soa_return;														\
+})
+
+// removes a certain number of elements or less, if not enough elements are available
+// _id:		C conform identifier
+// fifo:	position of the fifo within the array, 0 <= fifo < _fff_soa_size(_id)
+// amount:	amount of elements which will be removed, amount >= 0 (positive integer)
+#define _fff_soa_remove(_id, fifo, amount)								\
+do{																		\
+	size_t _soa_n = (fifo);												\
+	typeof(_id.level[0]) _soa_amount = _min((size_t)(amount), (size_t)_id.level[_soa_n]);	\
+	_id.level[_soa_n] -= _soa_amount;									\
+	_id.read[_soa_n] = (_id.read[_soa_n]+_soa_amount) & _fff_soa_mem_mask(_id);	\
+}while(0)
+
+// returns the next element of a fifo and removes it from the memory
+// Use if(!_fff_soa_is_empty(_id, fifo)) if amount of stored data is unknown
+// _id:		C conform identifier
+// fifo:	position of the fifo within the array, 0 <= fifo < _fff_soa_size(_id)
+#define _fff_soa_read_lite(_id, fifo)									\
+({																		\
+	size_t _soa_n = (fifo);												\
+	typeof(_id.data[0][0]) _soa_return = _id.data[_soa_n][_id.read[_soa_n]];	\
+	_id.read[_soa_n] = (_id.read[_soa_n]+1) & _fff_soa_mem_mask(_id);	\
+	_id.level[_soa_n]--;												\
+	_soa_return;														\
+})
+
+// returns the next element of a fifo and removes it from the memory
+// if no element is available, 0 is returned
+// _id:		C conform identifier
+// fifo:	position of the fifo within the array, 0 <= fifo < _fff_soa_size(_id)
+#define _fff_soa_read(_id, fifo)										\
+({																		\
+	size_t _soa_m = (fifo);												\
+	typeof(_id.data[0][0]) _soa_value = (typeof(_id.data[0][0])){0};	\
+	if (!_fff_soa_is_empty(_id, _soa_m))								\
+		_soa_value = _fff_soa_read_lite(_id, _soa_m);					\
+	_soa_value;															\
+})
+
+// adds an element to a fifo
+// Use if(!_fff_soa_is_full(_id, fifo)) if amount of stored data is unknown
+// _id:		C conform identifier
+// fifo:	position of the fifo within the array, 0 <= fifo < _fff_soa_size(_id)
+// newdata:	data to be written
+#define _fff_soa_write_lite(_id, fifo, newdata)							\
+do{																		\
+	size_t _soa_n = (fifo);												\
+	_id.data[_soa_n][_id.write[_soa_n]] = (newdata);					\
+	_id.write[_soa_n] = (_id.write[_soa_n]+1) & _fff_soa_mem_mask(_id);	\
+	_id.level[_soa_n]++;												\
+}while(0)
+
+// adds an element to a fifo, if space is available; if full the element will be dismissed
+// _id:		C conform identifier
+// fifo:	position of the fifo within the array, 0 <= fifo < _fff_soa_size(_id)
+// newdata:	data to be written
+#define _fff_soa_write(_id, fifo, newdata)								\
+do{																		\
+	size_t _soa_m = (fifo);												\
+	if (!_fff_soa_is_full(_id, _soa_m))									\
+		_fff_soa_write_lite(_id, _soa_m, newdata);						\
+}while(0)
+
+// allows accessing the data of a fifo as an array without removing any elements, see _fff_peek(...)
+// _id:		C conform identifier
+// fifo:	position of the fifo within the array, 0 <= fifo < _fff_soa_size(_id)
+// idx:		offset from the first element in the fifo
+#define _fff_soa_peek(_id, fifo, idx)									\
+	_id.data[fifo][(_id.read[fifo]+(idx)) & _fff_soa_mem_mask(_id)]
+
+
+//////////////////////////////////////////////////////////////////////////
+// lock-free single-producer/single-consumer macros (_fff_spsc_*)
+//////////////////////////////////////////////////////////////////////////
+
+// The fifos above share the member 'level' between the writing and the reading side, so every
+// access must be atomic. An spsc fifo instead stores only two free-running indices: 'write' is
+// modified exclusively by the producer, 'read' exclusively by the consumer. Both indices count from
+// 0 to 2*depth-1, so a full fifo can be distinguished from an empty one without 'level'.
+// Each side publishes its index with a release store and observes the other index with an acquire
+// load (GCC '__atomic' builtins, identical to the C11 memory model). Thus exactly one producer and
+// one consumer (thread or ISR) may access the fifo concurrently without any lock.
+// Additionally each side keeps a private copy of the other side's index ('read_cache' and
+// 'write_cache') and only reloads it, if the fifo appears to be full or empty. A copy may be older
+// than the index, but it never lags more than one lap behind: every macro which moves an index
+// advances the copy of its own side as well, if necessary (see _FFF_SPSC_CACHE_WRITE(...)).
+//
+// On 8bit MCUs the indices are only accessed atomically if they fit into a single byte, so limit
+// the depth to 128 elements there.
+//
+// To publish an index only once for many elements, use the batched macros _fff_spsc_write_batch(...)
+// and _fff_spsc_read_batch(...). They keep a private index ('write_local' and 'read_local') and
+// publish it after FIFOFAST_SPSC_BATCH elements, when the fifo appears full (producer) or once all
+// elements of the last snapshot have been read (consumer). The producer MUST call _fff_spsc_flush(...)
+// at the end of a burst, otherwise the last elements are never seen by the consumer. Each side must
+// flush before switching from the batched to the regular macros; the regular macros keep the
+// private index up to date, so switching back needs no extra step.
+//
+// The variant _fff_declare_spsc_cl(...) places the producer's members, the consumer's members and
+// the data array on separate cache lines (see 'FIFOFAST_CACHE_LINE_SIZE'). If producer and consumer
+// run on different cores, an update of one index then no longer invalidates the cache line holding
+// the other index. This costs up to 3 cache lines of RAM and is only useful on multi-core systems.
+//
+// _id:		C conform identifier
+// _type:	any C type except pointers and structs. To store pointers or structs use typedef first
+// _depth:	maximum amount of elements, see _fff_declare(...)
+// _options:	(optional) FFF_OPT_NONE or FFF_OPT_WAIT, default FFF_OPT_NONE
+#define _fff_declare_spsc(...)			_VFUNC(_FFF_DECLARE_SPSC_, __NARG__(__VA_ARGS__)) (__VA_ARGS__)
+#define _fff_declare_spsc_cl(...)		_VFUNC(_FFF_DECLARE_SPSC_CL_, __NARG__(__VA_ARGS__)) (__VA_ARGS__)
+#define _FFF_DECLARE_SPSC_3(_type, _id, _depth)						_FFF_DECLARE_SPSC(_type, _id, _depth, , FFF_OPT_NONE)
+#define _FFF_DECLARE_SPSC_4(_type, _id, _depth, _options)			_FFF_DECLARE_SPSC(_type, _id, _depth, , _options)
+#define _FFF_DECLARE_SPSC_CL_3(_type, _id, _depth)					_FFF_DECLARE_SPSC(_type, _id, _depth, _FFF_ALIGN_CL, FFF_OPT_NONE)
+#define _FFF_DECLARE_SPSC_CL_4(_type, _id, _depth, _options)		_FFF_DECLARE_SPSC(_type, _id, _depth, _FFF_ALIGN_CL, _options)
+
+#define _FFF_DECLARE_SPSC(_type, _id, _depth, _align, _options)		\
+struct _FFF_NAME_STRUCT(_id) {											\
+	/* producer */														\
+	_FFF_GET_TYPE_SPSC(_depth) write									\
+		_FFF_ALIGN_ATOMIC(_FFF_GET_TYPE_SPSC(_depth)) _align;			\
+	_FFF_GET_TYPE_SPSC(_depth) read_cache;								\
+	_FFF_GET_TYPE_SPSC(_depth) write_local;								\
+	/* consumer */														\
+	_FFF_GET_TYPE_SPSC(_depth) read										\
+		_FFF_ALIGN_ATOMIC(_FFF_GET_TYPE_SPSC(_depth)) _align;			\
+	_FFF_GET_TYPE_SPSC(_depth) write_cache;								\
+	_FFF_GET_TYPE_SPSC(_depth) read_local;								\
+	_type data[_FFF_GET_ARRAYDEPTH(_depth)] _align;						\
+	_FFF_MEMBERS_OPT(_options, _FFF_GET_ARRAYDEPTH(_depth))				\
+} _id
+
+#define _fff_init_spsc(_id)												\
+struct _FFF_NAME_STRUCT(_id) _id =										\
+{																		\
+	.write			= 0,												\
+	.read_cache		= 0,												\
+	.write_local	= 0,												\
+	.read			= 0,												\
+	.write_cache	= 0,												\
+	.read_local		= 0,												\
+	.data			= {}												\
+}
+
+
+// masks a free-running spsc index to its valid range 0 ... 2*depth-1
+// _id:		C conform identifier
+// idx:		the index value to mask
+#define _FFF_SPSC_WRAP(_id, idx)		((idx) & (2*_fff_mem_depth(_id)-1))
+
+// PRODUCER ONLY: must be called before 'write' is advanced by n elements. The fifo never holds more
+// than depth elements, so 'read' is at least write+n-depth afterwards; 'read_cache' is raised to
+// this bound if it lags further behind. This keeps the distance from 'read_cache' to 'write'
+// within 0 ... depth, so it can't alias after a wrap of the free-running indices.
+// _id:		C conform identifier
+// _write:	current write index of the producer
+// n:		amount of elements to be added
+#define _FFF_SPSC_CACHE_WRITE(_id, _write, n)							\
+do{																		\
+	if (_FFF_SPSC_WRAP(_id, (_write)-_id.read_cache) + (n) > _fff_mem_depth(_id))	\
+		_id.read_cache = _FFF_SPSC_WRAP(_id, (_write)+(n)-_fff_mem_depth(_id));	\
+}while(0)
+
+// CONSUMER ONLY: must be called before 'read' is advanced by n elements. Only stored elements can
+// be removed, so 'write' is at least read+n; 'write_cache' is raised to this bound if necessary.
+// _id:		C conform identifier
+// _read:	current read index of the consumer
+// n:		amount of elements to be removed
+#define _FFF_SPSC_CACHE_READ(_id, _read, n)								\
+do{																		\
+	if (_FFF_SPSC_WRAP(_id, _id.write_cache-(_read)) < (n))				\
+		_id.write_cache = _FFF_SPSC_WRAP(_id, (_read)+(n));				\
+}while(0)
+
+// returns the current fill level of the fifo. Can be called from both sides; the value returned
+// to the producer can only grow, the value returned to the consumer can only shrink.
+// _id: C conform identifier
+#define _fff_spsc_mem_level(_id)										\
+	_FFF_SPSC_WRAP(_id, __atomic_load_n(&_id.write, __ATOMIC_ACQUIRE)	\
+		- __atomic_load_n(&_id.read, __ATOMIC_ACQUIRE))
+
+// returns the current free space of the fifo
+// _id: C conform identifier
+#define _fff_spsc_mem_free(_id)			(_fff_mem_depth(_id) - _fff_spsc_mem_level(_id))
+
+// returns !0 if empty
+#define _fff_spsc_is_empty(_id)			(_fff_spsc_mem_level(_id) == 0)
+
+// returns !0 if full
+#define _fff_spsc_is_full(_id)			(_fff_spsc_mem_level(_id) > _fff_mem_mask(_id))
+
+// clears/ resets buffer completely
+// Neither the producer nor the consumer may access the fifo at the same time.
+// _id:		C conform identifier
+#define _fff_spsc_reset(_id)											\
+do{																		\
+	__atomic_store_n(&_id.write, 0, __ATOMIC_RELAXED);					\
+	__atomic_store_n(&_id.read, 0, __ATOMIC_RELAXED);					\
+	_id.read_cache = 0;													\
+	_id.write_local = 0;												\
+	_id.write_cache = 0;												\
+	_id.read_local = 0;													\
+}while(0)
+
+
+// PRODUCER ONLY: adds an element to the fifo
+// Use if(!_fff_spsc_is_full(_id)) if amount of stored data is unknown
+// _id:		C conform identifier
+// newdata:	data to be written
+#define _fff_spsc_write_lite(_id, newdata)								\
+do{																		\
+	typeof(_id.write) _write = __atomic_load_n(&_id.write, __ATOMIC_RELAXED);	\
+	_FFF_SPSC_CACHE_WRITE(_id, _write, 1);								\
+	_id.data[_fff_wrap(_id, _write)] = (newdata);						\
+	_id.write_local = _FFF_SPSC_WRAP(_id, _write+1);					\
+	__atomic_store_n(&_id.write, _id.write_local, __ATOMIC_RELEASE);	\
+}while(0)
+
+// PRODUCER ONLY: adds an element to the fifo, if space is available
+// if full the element will be dismissed. Returns !0 if the element was written.
+// _id:		C conform identifier
+// newdata:	data to be written
+#define _fff_spsc_write(_id, newdata)									\
+({																		\
+	uint8_t _return = 0;												\
+	typeof(_id.write) _write = __atomic_load_n(&_id.write, __ATOMIC_RELAXED);	\
+	/* only touch the consumer's cache line if the fifo appears full */	\
+	if (_FFF_SPSC_WRAP(_id, _write-_id.read_cache) >= _fff_mem_depth(_id))	\
+		_id.read_cache = __atomic_load_n(&_id.read, __ATOMIC_ACQUIRE);	\
+	if (_FFF_SPSC_WRAP(_id, _write-_id.read_cache) < _fff_mem_depth(_id))	\
+	{																	\
+		_id.data[_fff_wrap(_id, _write)] = (newdata);					\
+		_id.write_local = _FFF_SPSC_WRAP(_id, _write+1);				\
+		__atomic_store_n(&_id.write, _id.write_local, __ATOMIC_RELEASE);	\
+		_return = 1;													\
+	}																	\
+	_return;															\
+})
+
+
+// CONSUMER ONLY: returns the next element from the fifo and removes it from the memory
+// Use if(!_fff_spsc_is_empty(_id)) if amount of stored data is unknown
+// _id: C conform identifier
+#define _fff_spsc_read_lite(_id)										\
+({																		\
+	typeof(_id.read) _read = __atomic_load_n(&_id.read, __ATOMIC_RELAXED);		\
+	_FFF_SPSC_CACHE_READ(_id, _read, 1);								\
+	typeof(_id.data[0]) _return = _id.data[_fff_wrap(_id, _read)];		\
+	_id.read_local = _FFF_SPSC_WRAP(_id, _read+1);						\
+	__atomic_store_n(&_id.read, _id.read_local, __ATOMIC_RELEASE);		\
+	_return;															\
+})
+
+// CONSUMER ONLY: copies the next element from the fifo to 'data_p' and removes it from the memory
+// Returns !0 if an element was read, 0 if the fifo was empty ('*data_p' is not modified then).
+// _id:		C conform identifier
+// data_p:	pointer to the destination, must be of type 'typeof(_id.data[0])*'
+#define _fff_spsc_read(_id, data_p)										\
+({																		\
+	uint8_t _return = 0;												\
+	typeof(_id.read) _read = __atomic_load_n(&_id.read, __ATOMIC_RELAXED);		\
+	/* only touch the producer's cache line if the fifo appears empty; */	\
+	/* a cached level of 0 or above depth wraps to depth or more */		\
+	if (_FFF_SPSC_WRAP(_id, _id.write_cache-_read-1) >= _fff_mem_depth(_id))	\
+		_id.write_cache = __atomic_load_n(&_id.write, __ATOMIC_ACQUIRE);	\
+	if (_id.write_cache != _read)										\
+	{																	\
+		*(data_p) = _id.data[_fff_wrap(_id, _read)];					\
+		_id.read_local = _FFF_SPSC_WRAP(_id, _read+1);					\
+		__atomic_store_n(&_id.read, _id.read_local, __ATOMIC_RELEASE);	\
+		_return = 1;													\
+	}																	\
+	_return;															\
+})
+
+// CONSUMER ONLY: allows accessing the data of the fifo as an array without removing any elements
+// Only elements below _fff_spsc_mem_level(_id) contain valid data; other elements may be written
+// by the producer at any time.
+// _id:		C conform identifier
+// idx:		Offset from the first element in the buffer
+#define _fff_spsc_peek(_id, idx)										\
+	_id.data[_fff_wrap(_id, __atomic_load_n(&_id.read, __ATOMIC_RELAXED)+(idx))]
+
+// PRODUCER ONLY: returns up to two blocks of free elements, see _fff_write_reserve(...)
+// Nothing is visible to the consumer until _fff_spsc_write_commit(...) is called, so a whole batch
+// is published with a single index update.
+// _id:		C conform identifier
+// n:		maximum amount of elements to reserve
+#define _fff_spsc_write_reserve(_id, n)									\
+({																		\
+	fff_span_t _return;													\
+	typeof(_id.write) _write = __atomic_load_n(&_id.write, __ATOMIC_RELAXED);	\
+	size_t _used = _FFF_SPSC_WRAP(_id, _write-_id.read_cache);			\
+	/* reload if the cache shows too little space or can't be valid */	\
+	if (_used > _fff_mem_depth(_id) || _fff_mem_depth(_id)-_used < (n))	\
+	{																	\
+		_id.read_cache = __atomic_load_n(&_id.read, __ATOMIC_ACQUIRE);	\
+		_used = _min(_FFF_SPSC_WRAP(_id, _write-_id.read_cache), _fff_mem_depth(_id));	\
+	}																	\
+	size_t _amount = _min(_fff_mem_depth(_id)-_used, (n));				\
+	_return.ptr[0] = &_id.data[_fff_wrap(_id, _write)];					\
+	_return.ptr[1] = &_id.data[0];										\
+	_return.len[0] = _min(_amount, _fff_mem_depth(_id) - _fff_wrap(_id, _write));	\
+	_return.len[1] = _amount - _return.len[0];							\
+	_return;															\
+})
+
+// PRODUCER ONLY: publishes n elements filled after _fff_spsc_write_reserve(...)
+// _id:		C conform identifier
+// n:		amount of elements to add; must not exceed the amount reserved before
+#define _fff_spsc_write_commit(_id, n)									\
+do{																		\
+	typeof(_id.write) _write = __atomic_load_n(&_id.write, __ATOMIC_RELAXED);	\
+	_FFF_SPSC_CACHE_WRITE(_id, _write, (n));							\
+	_id.write_local = _FFF_SPSC_WRAP(_id, _write+(n));					\
+	__atomic_store_n(&_id.write, _id.write_local, __ATOMIC_RELEASE);	\
+}while(0)
+
+// CONSUMER ONLY: returns up to two blocks of stored elements, see _fff_read_acquire(...)
+// _id:		C conform identifier
+// n:		maximum amount of elements to acquire
+#define _fff_spsc_read_acquire(_id, n)									\
+({																		\
+	fff_span_t _return;													\
+	typeof(_id.read) _read = __atomic_load_n(&_id.read, __ATOMIC_RELAXED);		\
+	size_t _level = _FFF_SPSC_WRAP(_id, _id.write_cache-_read);			\
+	/* reload if the cache shows too few elements or can't be valid */	\
+	if (_level > _fff_mem_depth(_id) || _level < (n))					\
+	{																	\
+		_id.write_cache = __atomic_load_n(&_id.write, __ATOMIC_ACQUIRE);	\
+		_level = _min(_FFF_SPSC_WRAP(_id, _id.write_cache-_read), _fff_mem_depth(_id));	\
+	}																	\
+	size_t _amount = _min(_level, (n));									\
+	_return.ptr[0] = &_id.data[_fff_wrap(_id, _read)];					\
+	_return.ptr[1] = &_id.data[0];										\
+	_return.len[0] = _min(_amount, _fff_mem_depth(_id) - _fff_wrap(_id, _read));	\
+	_return.len[1] = _amount - _return.len[0];							\
+	_return;															\
+})
+
+// CONSUMER ONLY: removes n elements after they have been processed with _fff_spsc_read_acquire(...)
+// _id:		C conform identifier
+// n:		amount of elements to remove; must not exceed the amount acquired before
+#define _fff_spsc_read_release(_id, n)									\
+do{																		\
+	typeof(_id.read) _read = __atomic_load_n(&_id.read, __ATOMIC_RELAXED);		\
+	_FFF_SPSC_CACHE_READ(_id, _read, (n));								\
+	_id.read_local = _FFF_SPSC_WRAP(_id, _read+(n));					\
+	__atomic_store_n(&_id.read, _id.read_local, __ATOMIC_RELEASE);		\
+}while(0)
+
+// PRODUCER ONLY: adds an element to the fifo without publishing it immediately, if space is
+// available. If full the element will be dismissed. Returns !0 if the element was written.
+// The element becomes visible to the consumer once FIFOFAST_SPSC_BATCH elements are pending, the
+// fifo appears full or _fff_spsc_flush(...) is called.
+// _id:		C conform identifier
+// newdata:	data to be written
+#define _fff_spsc_write_batch(_id, newdata)								\
+({																		\
+	uint8_t _return = 0;												\
+	typeof(_id.write) _write = _id.write_local;							\
+	if (_FFF_SPSC_WRAP(_id, _write-_id.read_cache) >= _fff_mem_depth(_id))	\
+		_id.read_cache = __atomic_load_n(&_id.read, __ATOMIC_ACQUIRE);	\
+	if (_FFF_SPSC_WRAP(_id, _write-_id.read_cache) < _fff_mem_depth(_id))	\
+	{																	\
+		_id.data[_fff_wrap(_id, _write)] = (newdata);					\
+		_id.write_local = _write = _FFF_SPSC_WRAP(_id, _write+1);		\
+		_return = 1;													\
+	}																	\
+	/* publish a complete batch; if full, the consumer needs the pending elements to proceed */	\
+	if (!_return || _FFF_SPSC_WRAP(_id, _write-__atomic_load_n(&_id.write, __ATOMIC_RELAXED))	\
+			>= FIFOFAST_SPSC_BATCH)										\
+		_fff_spsc_flush(_id);											\
+	_return;															\
+})
+
+// PRODUCER ONLY: publishes all elements written by _fff_spsc_write_batch(...) with a single store
+// _id:		C conform identifier
+#define _fff_spsc_flush(_id)											\
+	__atomic_store_n(&_id.write, _id.write_local, __ATOMIC_RELEASE)
+
+// CONSUMER ONLY: copies the next element from the fifo to 'data_p' without publishing the free
+// space immediately. The producer's index is loaded once and all elements below it are read before
+// it is loaded again. Returns !0 if an element was read, 0 if the fifo was empty ('*data_p' is not
+// modified then).
+// The free space becomes visible to the producer once FIFOFAST_SPSC_BATCH elements are pending, the
+// snapshot is drained or _fff_spsc_read_flush(...) is called.
+// _id:		C conform identifier
+// data_p:	pointer to the destination, must be of type 'typeof(_id.data[0])*'
+#define _fff_spsc_read_batch(_id, data_p)								\
+({																		\
+	uint8_t _return = 0;												\
+	typeof(_id.read) _read = _id.read_local;							\
+	if (_FFF_SPSC_WRAP(_id, _id.write_cache-_read-1) >= _fff_mem_depth(_id))	\
+	{																	\
+		/* snapshot drained (or invalid): hand back the space, then take a new one */	\
+		_fff_spsc_read_flush(_id);										\
+		_id.write_cache = __atomic_load_n(&_id.write, __ATOMIC_ACQUIRE);	\
+	}																	\
+	if (_id.write_cache != _read)										\
+	{																	\
+		*(data_p) = _id.data[_fff_wrap(_id, _read)];					\
+		_id.read_local = _read = _FFF_SPSC_WRAP(_id, _read+1);			\
+		_return = 1;													\
+		if (_FFF_SPSC_WRAP(_id, _read-__atomic_load_n(&_id.read, __ATOMIC_RELAXED))	\
+				>= FIFOFAST_SPSC_BATCH)									\
+			_fff_spsc_read_flush(_id);									\
+	}																	\
+	_return;															\
+})
+
+// CONSUMER ONLY: publishes the space of all elements read by _fff_spsc_read_batch(...)
+// _id:		C conform identifier
+#define _fff_spsc_read_flush(_id)										\
+	__atomic_store_n(&_id.read, _id.read_local, __ATOMIC_RELEASE)
+
+// CONSUMER ONLY: removes a certain number of elements or less, if not enough elements are available.
+// _id:		C conform identifier
+// amount:	Amount of elements which will be removed, amount >= 0 (positive integer)
+#define _fff_spsc_remove(_id, amount)									\
+do{																		\
+	typeof(_id.read) _read = __atomic_load_n(&_id.read, __ATOMIC_RELAXED);		\
+	_id.write_cache = __atomic_load_n(&_id.write, __ATOMIC_ACQUIRE);	\
+	typeof(_id.read) _level = _FFF_SPSC_WRAP(_id, _id.write_cache - _read);	\
+	typeof(_id.read) _amount = _min((amount), _level);					\
+	_id.read_local = _FFF_SPSC_WRAP(_id, _read+_amount);				\
+	__atomic_store_n(&_id.read, _id.read_local, __ATOMIC_RELEASE);		\
+}while(0)
+
+
+//////////////////////////////////////////////////////////////////////////
+// lock-free multi-producer/multi-consumer macros (_fff_mpmc_*)
+//////////////////////////////////////////////////////////////////////////
+
+// An mpmc fifo may be accessed by any number of producers and consumers concurrently. It uses the
+// same power-of-two data array as all other fifos, but each slot gets an additional sequence number
+// 'seq[]'. A producer claims the slot at position 'write' with a single compare-and-swap, fills it
+// and then publishes it by advancing the sequence number; consumers do the same with 'read'. Thus
+// producers and consumers never wait for each other and a stalled thread blocks only its own slot.
+//
+// 'seq[]' stores the sequence number relative to the slot index, so a zero-initialized fifo is
+// valid and the fifo can be stored in '.bss'. For a slot 'idx' at free-running position 'pos'
+// ('pos - idx' is the current lap):
+//		seq[idx] == pos-idx		the slot is free and can be written
+//		seq[idx] == pos-idx+1	the slot contains data and can be read
+//
+// Intended for multi-core systems. On single-core MCUs a regular fifo in an atomic block is faster.
+//
+// The variant _fff_declare_mpmc_cl(...) places 'write', 'read' and both arrays on separate cache
+// lines, so producers and consumers do not invalidate each other's index.
+//
+// _id:		C conform identifier
+// _type:	any C type except pointers and structs. To store pointers or structs use typedef first
+// _depth:	maximum amount of elements, see _fff_declare(...)
+// _options:	(optional) FFF_OPT_NONE or FFF_OPT_WAIT, default FFF_OPT_NONE
+#define _fff_declare_mpmc(...)			_VFUNC(_FFF_DECLARE_MPMC_, __NARG__(__VA_ARGS__)) (__VA_ARGS__)
+#define _fff_declare_mpmc_cl(...)		_VFUNC(_FFF_DECLARE_MPMC_CL_, __NARG__(__VA_ARGS__)) (__VA_ARGS__)
+#define _FFF_DECLARE_MPMC_3(_type, _id, _depth)						_FFF_DECLARE_MPMC(_type, _id, _depth, , FFF_OPT_NONE)
+#define _FFF_DECLARE_MPMC_4(_type, _id, _depth, _options)			_FFF_DECLARE_MPMC(_type, _id, _depth, , _options)
+#define _FFF_DECLARE_MPMC_CL_3(_type, _id, _depth)					_FFF_DECLARE_MPMC(_type, _id, _depth, _FFF_ALIGN_CL, FFF_OPT_NONE)
+#define _FFF_DECLARE_MPMC_CL_4(_type, _id, _depth, _options)		_FFF_DECLARE_MPMC(_type, _id, _depth, _FFF_ALIGN_CL, _options)
+
+#define _FFF_DECLARE_MPMC(_type, _id, _depth, _align, _options)		\
+struct _FFF_NAME_STRUCT(_id) {											\
+	fff_seq_t write _FFF_ALIGN_ATOMIC(fff_seq_t) _align;				\
+	fff_seq_t read _FFF_ALIGN_ATOMIC(fff_seq_t) _align;					\
+	fff_seq_t seq[_FFF_GET_ARRAYDEPTH(_depth)] _FFF_ALIGN_ATOMIC(fff_seq_t) _align;	\
+	_type data[_FFF_GET_ARRAYDEPTH(_depth)] _align;						\
+	_FFF_MEMBERS_OPT(_options, _FFF_GET_ARRAYDEPTH(_depth))				\
+} _id
+
+#define _fff_init_mpmc(_id)												\
+struct _FFF_NAME_STRUCT(_id) _id =										\
+{																		\
+	.write	= 0,														\
+	.read	= 0,														\
+	.seq	= {},														\
+	.data	= {}														\
+}
+
+
+// returns the approximate fill level of the fifo. Elements which are currently being written or
+// read by another thread may or may not be counted.
+// _id: C conform identifier
+#define _fff_mpmc_mem_level(_id)										\
+({																		\
+	fff_seq_t _read = __atomic_load_n(&_id.read, __ATOMIC_RELAXED);	\
+	fff_seq_t _level = __atomic_load_n(&_id.write, __ATOMIC_RELAXED) - _read;	\
+	_min(_level, (fff_seq_t)_fff_mem_depth(_id));						\
+})
+
+// returns the approximate free space of the fifo
+// _id: C conform identifier
+#define _fff_mpmc_mem_free(_id)			(_fff_mem_depth(_id) - _fff_mpmc_mem_level(_id))
+
+// returns !0 if (approximately) empty
+#define _fff_mpmc_is_empty(_id)			(_fff_mpmc_mem_level(_id) == 0)
+
+// returns !0 if (approximately) full
+#define _fff_mpmc_is_full(_id)			(_fff_mpmc_mem_level(_id) > _fff_mem_mask(_id))
+
+// clears/ resets buffer completely; option members (e.g. the eventfd of FFF_OPT_EVENT) are kept
+// No other thread may access the fifo at the same time.
+// _id:		C conform identifier
+#define _fff_mpmc_reset(_id)											\
+do{																		\
+	__atomic_store_n(&_id.write, 0, __ATOMIC_RELAXED);					\
+	__atomic_store_n(&_id.read, 0, __ATOMIC_RELAXED);					\
+	memset(_id.seq, 0, sizeof(_id.seq));								\
+}while(0)
+
+
+// adds an element to the fifo, if space is available
+// if full the element will be dismissed. Returns !0 if the element was written.
+// _id:		C conform identifier
+// newdata:	data to be written
+#define _fff_mpmc_write(_id, newdata)									\
+({																		\
+	uint8_t _return = 0;												\
+	fff_seq_t _pos = __atomic_load_n(&_id.write, __ATOMIC_RELAXED);		\
+	while (1)															\
+	{																	\
+		fff_seq_t _idx = _fff_wrap(_id, _pos);							\
+		fff_seq_diff_t _dif = (fff_seq_diff_t)							\
+			(__atomic_load_n(&_id.seq[_idx], __ATOMIC_ACQUIRE) - (_pos-_idx));	\
+		if (_dif == 0)													\
+		{																\
+			/* slot is free, try to claim it */							\
+			if (__atomic_compare_exchange_n(&_id.write, &_pos, _pos+1,	\
+				1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))					\
+			{															\
+				_id.data[_idx] = (newdata);								\
+				__atomic_store_n(&_id.seq[_idx], _pos-_idx+1, __ATOMIC_RELEASE);	\
+				_return = 1;											\
+				break;													\
+			}															\
+			/* on failure '_pos' has been updated by the CAS */			\
+		}																\
+		else if (_dif < 0)												\
+			break;					/* slot still holds data: full */	\
+		else															\
+			_pos = __atomic_load_n(&_id.write, __ATOMIC_RELAXED);		\
+	}																	\
+	_return;															\
+})
+
+// copies the next element from the fifo to 'data_p' and removes it from the memory
+// Returns !0 if an element was read, 0 if the fifo was empty ('*data_p' is not modified then).
+// _id:		C conform identifier
+// data_p:	pointer to the destination, must be of type 'typeof(_id.data[0])*'
+#define _fff_mpmc_read(_id, data_p)										\
+({																		\
+	uint8_t _return = 0;												\
+	fff_seq_t _pos = __atomic_load_n(&_id.read, __ATOMIC_RELAXED);		\
+	while (1)															\
+	{																	\
+		fff_seq_t _idx = _fff_wrap(_id, _pos);							\
+		fff_seq_diff_t _dif = (fff_seq_diff_t)							\
+			(__atomic_load_n(&_id.seq[_idx], __ATOMIC_ACQUIRE) - (_pos-_idx+1));	\
+		if (_dif == 0)													\
+		{																\
+			/* slot holds data, try to claim it */						\
+			if (__atomic_compare_exchange_n(&_id.read, &_pos, _pos+1,	\
+				1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))					\
+			{															\
+				*(data_p) = _id.data[_idx];								\
+				__atomic_store_n(&_id.seq[_idx], _pos-_idx+_fff_mem_depth(_id), __ATOMIC_RELEASE);	\
+				_return = 1;											\
+				break;													\
+			}															\
+		}																\
+		else if (_dif < 0)												\
+			break;					/* slot not written yet: empty */	\
+		else															\
+			_pos = __atomic_load_n(&_id.read, __ATOMIC_RELAXED);		\
+	}																	\
+	_return;															\
+})
+
+
+//////////////////////////////////////////////////////////////////////////
+// wait-free multi-producer/single-consumer macros (_fff_mpsc_*)
+//////////////////////////////////////////////////////////////////////////
+
+// An mpsc fifo may be written by any number of producers (threads or ISRs), but read by only one
+// consumer. It is cheaper than an mpmc fifo as no operation ever loops:
+// A producer reserves space by incrementing 'level' and a slot by incrementing 'write' (one atomic
+// fetch-add each), fills the slot and sets its 'ready' flag. The consumer checks the 'ready' flag
+// of the next slot, takes the data, clears the flag and releases the space again. It never needs a
+// compare-and-swap.
+// The space reserved by a producer may have been released for a different slot than the one it
+// gets, so the producer checks that the 'ready' flag of its slot is cleared before writing. This
+// only waits if the consumer is releasing the previous lap of the slot on another core at the
+// same moment; on single-core MCUs the flag is always cleared already.
+//
+// NOTE: Elements are read in the order the slots were reserved. If a producer is interrupted after
+// reserving a slot, the consumer sees the fifo as empty until this slot has been filled.
+//
+// The variant _fff_declare_mpsc_cl(...) places 'write', 'level', the consumer's 'read' and the
+// data array on separate cache lines.
+//
+// _id:		C conform identifier
+// _type:	any C type except pointers and structs. To store pointers or structs use typedef first
+// _depth:	maximum amount of elements, see _fff_declare(...)
+// _options:	(optional) FFF_OPT_NONE or FFF_OPT_WAIT, default FFF_OPT_NONE
+#define _fff_declare_mpsc(...)			_VFUNC(_FFF_DECLARE_MPSC_, __NARG__(__VA_ARGS__)) (__VA_ARGS__)
+#define _fff_declare_mpsc_cl(...)		_VFUNC(_FFF_DECLARE_MPSC_CL_, __NARG__(__VA_ARGS__)) (__VA_ARGS__)
+#define _FFF_DECLARE_MPSC_3(_type, _id, _depth)						_FFF_DECLARE_MPSC(_type, _id, _depth, , FFF_OPT_NONE)
+#define _FFF_DECLARE_MPSC_4(_type, _id, _depth, _options)			_FFF_DECLARE_MPSC(_type, _id, _depth, , _options)
+#define _FFF_DECLARE_MPSC_CL_3(_type, _id, _depth)					_FFF_DECLARE_MPSC(_type, _id, _depth, _FFF_ALIGN_CL, FFF_OPT_NONE)
+#define _FFF_DECLARE_MPSC_CL_4(_type, _id, _depth, _options)		_FFF_DECLARE_MPSC(_type, _id, _depth, _FFF_ALIGN_CL, _options)
+
+#define _FFF_DECLARE_MPSC(_type, _id, _depth, _align, _options)		\
+struct _FFF_NAME_STRUCT(_id) {											\
+	fff_seq_t write _FFF_ALIGN_ATOMIC(fff_seq_t) _align;				\
+	fff_seq_t level _FFF_ALIGN_ATOMIC(fff_seq_t) _align;				\
+	_FFF_GET_TYPE(_depth) read _align;									\
+	uint8_t ready[_FFF_GET_ARRAYDEPTH(_depth)];							\
+	_type data[_FFF_GET_ARRAYDEPTH(_depth)] _align;						\
+	_FFF_MEMBERS_OPT(_options, _FFF_GET_ARRAYDEPTH(_depth))				\
+} _id
+
+#define _fff_init_mpsc(_id)												\
+struct _FFF_NAME_STRUCT(_id) _id =										\
+{																		\
+	.write	= 0,														\
+	.level	= 0,														\
+	.read	= 0,														\
+	.ready	= {},														\
+	.data	= {}														\
+}
+
+
+// returns the current fill level of the fifo including slots, which have been reserved by a
+// producer, but are not yet filled
+// _id: C conform identifier
+#define _fff_mpsc_mem_level(_id)										\
+	_min(__atomic_load_n(&_id.level, __ATOMIC_RELAXED), (fff_seq_t)_fff_mem_depth(_id))
+
+// returns the current free space of the fifo
+// _id: C conform identifier
+#define _fff_mpsc_mem_free(_id)			(_fff_mem_depth(_id) - _fff_mpsc_mem_level(_id))
+
+// CONSUMER ONLY: returns !0 if the next element is not (yet) available
+#define _fff_mpsc_is_empty(_id)											\
+	(__atomic_load_n(&_id.ready[_id.read], __ATOMIC_ACQUIRE) == 0)
+
+// returns !0 if full
+#define _fff_mpsc_is_full(_id)			(_fff_mpsc_mem_level(_id) > _fff_mem_mask(_id))
+
+// clears/ resets buffer completely; option members (e.g. the eventfd of FFF_OPT_EVENT) are kept
+// No other thread may access the fifo at the same time.
+// _id:		C conform identifier
+#define _fff_mpsc_reset(_id)											\
+do{																		\
+	__atomic_store_n(&_id.write, 0, __ATOMIC_RELAXED);					\
+	__atomic_store_n(&_id.level, 0, __ATOMIC_RELAXED);					\
+	_id.read = 0;														\
+	memset(_id.ready, 0, sizeof(_id.ready));							\
+}while(0)
+
+
+// adds an element to the fifo, if space is available. Wait-free, safe for any number of producers.
+// if full the element will be dismissed. Returns !0 if the element was written.
+// _id:		C conform identifier
+// newdata:	data to be written
+#define _fff_mpsc_write(_id, newdata)									\
+({																		\
+	uint8_t _return = 0;												\
+	/* reserve space; pairs with the release of the consumer */			\
+	if (__atomic_fetch_add(&_id.level, 1, __ATOMIC_ACQUIRE) < _fff_mem_depth(_id))	\
+	{																	\
+		fff_seq_t _idx = _fff_wrap(_id,									\
+			__atomic_fetch_add(&_id.write, 1, __ATOMIC_RELAXED));		\
+		/* wait for the consumer to release the slot's last lap */		\
+		/* (see above); pairs with the release of the 'ready' clear */	\
+		while (__atomic_load_n(&_id.ready[_idx], __ATOMIC_ACQUIRE));	\
+		_id.data[_idx] = (newdata);										\
+		__atomic_store_n(&_id.ready[_idx], 1, __ATOMIC_RELEASE);		\
+		_return = 1;													\
+	}																	\
+	else																\
+		__atomic_fetch_sub(&_id.level, 1, __ATOMIC_RELAXED);			\
+	_return;															\
+})
+
+
+// CONSUMER ONLY: returns the next element from the fifo and removes it from the memory
+// Use if(!_fff_mpsc_is_empty(_id)) if availability of the next element is unknown
+// _id: C conform identifier
+#define _fff_mpsc_read_lite(_id)										\
+({																		\
+	typeof(_id.read) _read = _id.read;									\
+	typeof(_id.data[0]) _return = _id.data[_read];						\
+	__atomic_store_n(&_id.ready[_read], 0, __ATOMIC_RELEASE);			\
+	_id.read = _fff_wrap(_id, _read+1);									\
+	__atomic_fetch_sub(&_id.level, 1, __ATOMIC_RELEASE);				\
+	_return;															\
+})
+
+// CONSUMER ONLY: copies the next element from the fifo to 'data_p' and removes it from the memory
+// Returns !0 if an element was read, 0 if the fifo was empty ('*data_p' is not modified then).
+// _id:		C conform identifier
+// data_p:	pointer to the destination, must be of type 'typeof(_id.data[0])*'
+#define _fff_mpsc_read(_id, data_p)										\
+({																		\
+	uint8_t _return = 0;												\
+	if (!_fff_mpsc_is_empty(_id))										\
+	{																	\
+		*(data_p) = _fff_mpsc_read_lite(_id);							\
+		_return = 1;													\
+	}																	\
+	_return;															\
+})
+
+
+//////////////////////////////////////////////////////////////////////////
+// Inline functions
+//////////////////////////////////////////////////////////////////////////
+
+// Inline functions MUST be defined in the .h, not in the .c file to work correctly!
+
+// auxiliary functions
+static inline fff_index_t fff_wrap(fff_proto_t *fifo, fff_index_t idx)
+{
+	return (idx & fifo->mask);
+}
+static inline void* fff_data_p(fff_proto_t *fifo, fff_index_t idx)
+{
+	return &(fifo->data[idx * fifo->data_size]);
+}
+// swaps two non-overlapping blocks of n bytes in chunks of the scratch buffer size
+static inline void fff_swap_blocks(uint8_t *a, uint8_t *b, size_t n)
+{
+	uint8_t tmp[FIFOFAST_REBASE_SCRATCH];
+	while (n)
+	{
+		size_t chunk = _min(n, sizeof(tmp));
+		memcpy(tmp, a, chunk);
+		memcpy(a, b, chunk);
+		memcpy(b, tmp, chunk);
+		a += chunk;
+		b += chunk;
+		n -= chunk;
+	}
+}
+// rotates n bytes by k bytes to the left: [A(k) B(n-k)] -> [B A]
+// Kept out of line: inlined into a small fifo, -Warray-bounds can't bound n-k by the array and reports
+// moves that never run. One call per rebase of wrapped data costs nothing next to the moves. Marked
+// unused, as translation units without a rebase don't call it.
+static void fff_rotate(uint8_t *data, size_t n, size_t k)
+{
+	uint8_t tmp[FIFOFAST_REBASE_SCRATCH];
+	if (k == 0 || k == n)
+		return;
+
+	// small part fits in scratch buffer: park it, shift the large part, put it back
+	if (k <= sizeof(tmp))
+	{
+		memcpy(tmp, data, k);
+		memmove(data, data+k, n-k);
+		memcpy(data+n-k, tmp, k);
+		return;
+	}
+	if (n-k <= sizeof(tmp))
+	{
+		memcpy(tmp, data+k, n-k);
+		memmove(data+n-k, data, k);
+		memcpy(data, tmp, n-k);
+		return;
+	}
+
+	// Gries-Mills block swap: each swap puts the smaller block into its final position
+	size_t i = k, j = n-k;
+	while (i != j)
+	{
+		if (i < j)
+		{
+			fff_swap_blocks(data+k-i, data+k+j-i, i);
+			j -= i;
+		}
+		else
+		{
+			fff_swap_blocks(data+k-i, data+k, j);
+			i -= j;
+		}
+	}
+	fff_swap_blocks(data+k-i, data+k, i);
+}
+// moves 'level' elements starting at 'read' to the start of the data array
+static inline void fff_rebase_data(void *data, size_t size, size_t read, size_t level, size_t depth)
+{
+	uint8_t *d		= data;
+	size_t first	= _min(level, depth-read);	// elements from 'read' to the end of the array
+	size_t second	= level - first;			// elements wrapped to the start of the array
+
+	if (second == 0)
+	{
+		memmove(d, d + read*size, first*size);
+		return;
+	}
+
+	// close the gap of free elements: [B - A] -> [B A], then rotate to [A B]
+	memmove(d + second*size, d + read*size, first*size);
+	fff_rotate(d, level*size, second*size);
+}
+// returns the index of the first set bit at or after 'start', wrapping around to bit 0 if required.
+// Returns -1 if no bit is set.
+static inline int fff_pq_find(const fff_pq_map_t *map, size_t words, size_t start)
+{
+	const size_t bits = 8*sizeof(fff_pq_map_t);
+	if (start >= words*bits)
+		start = 0;
+	
+	size_t w = start / bits;
+	fff_pq_map_t m = map[w] & (~(fff_pq_map_t)0 << (start % bits));
+	for (size_t k = 0; k <= words; k++)
+	{
+		if (m)
+			return w*bits + __builtin_ctzl(m);
+		w = (w+1 == words) ? 0 : w+1;
+		m = map[w];
+	}
+	return -1;
+}
+// adds a single value to a latency histogram
+static inline void fff_latency_record(uint32_t *bucket, fff_time_t time)
+{
+	const uint8_t sub = FIFOFAST_LATENCY_SUB_BITS;
+	size_t idx = time;
+	if (time >> sub)
+	{
+		// position of the highest bit selects the power of two, the following bits the sub-bucket
+		uint8_t exp = 8*sizeof(unsigned long long)-1 - __builtin_clzll(time);
+		idx = ((size_t)(exp-sub+1) << sub) + ((time >> (exp-sub)) & (((fff_time_t)1 << sub)-1));
+	}
+	__atomic_fetch_add(&bucket[idx], 1, __ATOMIC_RELAXED);
+}
+
+// returns the largest value, which is counted in the bucket 'idx'
+static inline fff_time_t fff_latency_upper(size_t idx)
+{
+	const uint8_t sub = FIFOFAST_LATENCY_SUB_BITS;
+	if (idx < ((size_t)1 << sub))
+		return idx;
+	uint8_t exp = (idx >> sub) + sub - 1;
+	fff_time_t mantissa = ((fff_time_t)1 << sub) + (idx & (((size_t)1 << sub)-1)) + 1;
+	return (mantissa << (exp-sub)) - 1;
+}
+
+static inline fff_time_t fff_latency_percentile(const uint32_t *bucket, uint32_t permille)
+{
+	uint64_t total = 0;
+	for (size_t k = 0; k < FFF_LATENCY_BUCKETS; k++)
+		total += __atomic_load_n(&bucket[k], __ATOMIC_RELAXED);
+	if (total == 0)
+		return 0;
+	
+	// the element at this rank (rounded up) falls into the bucket searched for
+	uint64_t rank = _limit_lo((total*permille + 999) / 1000, 1);
+	uint64_t sum = 0;
+	for (size_t k = 0; k < FFF_LATENCY_BUCKETS; k++)
+	{
+		sum += __atomic_load_n(&bucket[k], __ATOMIC_RELAXED);
+		if (sum >= rank)
+			return fff_latency_upper(k);
+	}
+	return fff_latency_upper(FFF_LATENCY_BUCKETS-1);
+}
+
+static inline fff_latency_t fff_latency_summary(const uint32_t *bucket)
+{
+	fff_latency_t result = {0};
+	for (size_t k = 0; k < FFF_LATENCY_BUCKETS; k++)
+	{
+		uint32_t count = __atomic_load_n(&bucket[k], __ATOMIC_RELAXED);
+		result.count += count;
+		if (count)
+			result.max = fff_latency_upper(k);
+	}
+	result.p50	= fff_latency_percentile(bucket, 500);
+	result.p99	= fff_latency_percentile(bucket, 990);
+	result.p999	= fff_latency_percentile(bucket, 999);
+	return result;
+}
+
+static inline fff_stats_t fff_stats_snapshot(const fff_stats_t *stats)
+{
+	fff_stats_t result;
+	result.written		= __atomic_load_n(&stats->written, __ATOMIC_RELAXED);
+	result.read			= __atomic_load_n(&stats->read, __ATOMIC_RELAXED);
+	result.dropped		= __atomic_load_n(&stats->dropped, __ATOMIC_RELAXED);
+	result.high_water	= __atomic_load_n(&stats->high_water, __ATOMIC_RELAXED);
+	result.full			= __atomic_load_n(&stats->full, __ATOMIC_RELAXED);
+	result.empty		= __atomic_load_n(&stats->empty, __ATOMIC_RELAXED);
+	return result;
+}
+
+static inline fff_stats_t fff_stats_reset(fff_stats_t *stats)
+{
+	fff_stats_t result;
+	result.written		= __atomic_exchange_n(&stats->written, 0, __ATOMIC_RELAXED);
+	result.read			= __atomic_exchange_n(&stats->read, 0, __ATOMIC_RELAXED);
+	result.dropped		= __atomic_exchange_n(&stats->dropped, 0, __ATOMIC_RELAXED);
+	result.high_water	= __atomic_exchange_n(&stats->high_water, 0, __ATOMIC_RELAXED);
+	result.full			= __atomic_exchange_n(&stats->full, 0, __ATOMIC_RELAXED);
+	result.empty		= __atomic_exchange_n(&stats->empty, 0, __ATOMIC_RELAXED);
+	return result;
+}
+
+static inline void fff_trace_init(fff_trace_t *trace, fff_trace_rec_t *rec, uint32_t size)
+{
+	memset(trace, 0, sizeof(*trace));
+	trace->rec	= rec;
+	trace->size	= size;
+}
+
+static inline void fff_trace_record(fff_trace_t *trace, uint8_t op, uint32_t count)
+{
+	fff_time_t now = FIFOFAST_TIMESTAMP();
+	fff_time_t diff = now - trace->last;
+	
+	if (trace->count >= trace->size && trace->flush != NULL)
+		trace->flush(trace);
+	if (trace->count >= trace->size)
+	{
+		// the time is added to the next record instead
+		trace->lost++;
+		return;
+	}
+	
+	trace->rec[trace->count].time	= (diff < UINT32_MAX) ? diff : UINT32_MAX;
+	trace->rec[trace->count].event	= op | ((count < 0xFFFFFF) ? count : 0xFFFFFF) << 8;
+	trace->count++;
+	trace->last = now;
+}
+
+static inline fff_index_t fff_mem_mask(fff_proto_t *fifo)
+{
+	return (fifo->mask);
+}
+static inline fff_index_t fff_data_size(fff_proto_t *fifo)
+{
+	return fifo->data_size;
+}
+
+//
+static inline uint8_t fff_is_empty(fff_proto_t *fifo)
+{
+	return (fifo->level == 0);
+}
+static inline uint8_t fff_is_full(fff_proto_t *fifo)
+{
+	return (fifo->level > fifo->mask);
+}
+static inline fff_level_t fff_mem_level(fff_proto_t *fifo)
+{
+	return (fifo->level);
+}
+static inline fff_index_t fff_mem_free(fff_proto_t *fifo)
+{
+	return (fifo->mask - fifo->level + 1);
+}
+
+//
+static inline void fff_reset(fff_proto_t *fifo)
+{
+	fifo->read	= 0;
+	fifo->write	= 0;
+	fifo->level = 0;
+}
+
+
+static inline void fff_remove(fff_proto_t *fifo, fff_level_t amount)
+{
+	if (amount > fifo->level)
+		amount = fifo->level;
+	fff_remove_lite(fifo, amount);
+}
+static inline void fff_remove_lite(fff_proto_t *fifo, fff_level_t amount)
+{
+	fifo->level -= amount;
+	fifo->read = fff_wrap(fifo, fifo->read + amount);
+}
+
+static inline void fff_write(fff_proto_t *fifo, void *data)
+{
+	if (!fff_is_full(fifo))
+	fff_write_lite(fifo,data);
+}
+static inline void fff_write_lite(fff_proto_t *fifo, void *data)
+{
+	memcpy(fff_data_p(fifo, fifo->write), data, fifo->data_size);
+	fifo->write = fff_wrap(fifo, fifo->write+1);
+	fifo->level++;
+}
+
+static inline fff_level_t fff_write_multiple(fff_proto_t *fifo, const void *data, fff_level_t n)
+{
+	fff_level_t amount	= _min(fff_mem_free(fifo), n);
+	fff_level_t first	= _min(amount, fifo->mask - fifo->write + 1);
+	memcpy(fff_data_p(fifo, fifo->write), data, first * fifo->data_size);
+	if (amount > first)
+		memcpy(fff_data_p(fifo, 0), (const uint8_t*)data + first * fifo->data_size, (amount - first) * fifo->data_size);
+	fifo->write = fff_wrap(fifo, fifo->write + amount);
+	fifo->level += amount;
+	return amount;
+}
+static inline fff_level_t fff_read_multiple(fff_proto_t *fifo, void *data, fff_level_t n)
+{
+	fff_level_t amount	= _min(fifo->level, n);
+	fff_level_t first	= _min(amount, fifo->mask - fifo->read + 1);
+	memcpy(data, fff_data_p(fifo, fifo->read), first * fifo->data_size);
+	if (amount > first)
+		memcpy((uint8_t*)data + first * fifo->data_size, fff_data_p(fifo, 0), (amount - first) * fifo->data_size);
+	fifo->read = fff_wrap(fifo, fifo->read + amount);
+	fifo->level -= amount;
+	return amount;
+}
+
+static inline void fff_rebase(fff_proto_t *fifo)
+{
+	if (fifo->read == 0)
+		return;
+	fff_rebase_data(fifo->data, fifo->data_size, fifo->read, fifo->level, (size_t)fifo->mask + 1);
+	fifo->read	= 0;
+	fifo->write	= fff_wrap(fifo, fifo->level);
+}
+static inline fff_level_t fff_linearize(fff_proto_t *fifo, void *data)
+{
+	fff_level_t first	= _min(fifo->level, fifo->mask - fifo->read + 1);
+	memcpy(data, fff_data_p(fifo, fifo->read), first * fifo->data_size);
+	if (fifo->level > first)
+		memcpy((uint8_t*)data + first * fifo->data_size, fff_data_p(fifo, 0), (fifo->level - first) * fifo->data_size);
+	return fifo->level;
 }
 
 // the peek function MUST be split into two to work as a normal c function
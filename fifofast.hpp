@@ -0,0 +1,275 @@
+/*
+ * fifofast.hpp
+ *
+ * Created: 17.10.2026 11:02:37
+ *
+ * Description:
+ * C++17 counterpart of the fifos declared by _fff_declare(...) in fifofast.h. The class template
+ * fifofast<T, N> uses the same memory layout rules: the depth is rounded up to the next 2^n value
+ * (at least 4) at compile time and the indices use the smallest unsigned type possible.
+ *
+ * Unlike the macros, elements are constructed in place and moved instead of copied, so any type can
+ * be stored, including std::string and move-only handles. For trivially copyable types 'if constexpr'
+ * branches skip the destructor calls, and write_multiple(...)/read_multiple(...) copy with memcpy
+ * like the function-like macros instead of looping over the elements.
+ *
+ * As with the macros, no access is atomic. If a fifo is accessed from an ISR or another thread,
+ * all other accesses must be placed within an atomic block or be protected by a mutex.
+ */
+
+
+#ifndef FIFOFAST_HPP_
+#define FIFOFAST_HPP_
+
+#include <cstdint>		// required for data types (uint8_t, uint16_t, ...)
+#include <cstddef>		// required for size_t
+#include <cstring>		// required for memcpy
+#include <new>			// required for placement new
+#include <type_traits>	// required for type selection and 'trivial'
+#include <utility>		// required for std::move, std::forward
+
+
+//////////////////////////////////////////////////////////////////////////
+// internal helpers
+//////////////////////////////////////////////////////////////////////////
+
+namespace fifofast_detail
+{
+	// rounds up given argument to next 2^n value, at least 4; equivalent to _FFF_GET_ARRAYDEPTH(...)
+	constexpr size_t array_depth(size_t depth)
+	{
+		size_t result = 4;
+		while (result < depth)
+			result <<= 1;
+		return result;
+	}
+
+	// returns smallest unsigned type for given integer; equivalent to _type_min(...)
+	template <uint64_t max>
+	using type_min = std::conditional_t<(max <= UINT8_MAX), uint8_t,
+					 std::conditional_t<(max <= UINT16_MAX), uint16_t,
+					 std::conditional_t<(max <= UINT32_MAX), uint32_t, uint64_t>>>;
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// class template fifofast<T, N>
+//////////////////////////////////////////////////////////////////////////
+
+// T:		any C++ type
+// N:		maximum amount of elements, see _fff_declare(...). Only values of 2^n are possible. If
+//			another value is passed the next larger value will be automatically selected.
+template <typename T, size_t N>
+class fifofast
+{
+public:
+	using value_type	= T;
+	using index_type	= fifofast_detail::type_min<fifofast_detail::array_depth(N)-1>;
+	using level_type	= fifofast_detail::type_min<fifofast_detail::array_depth(N)>;
+
+private:
+	static constexpr size_t depth	= fifofast_detail::array_depth(N);
+	static constexpr size_t mask	= depth-1;
+
+	// types with trivial copy and destruction are handled like in C: no destructor calls, memcpy
+	static constexpr bool trivial	= std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>;
+
+	index_type read		= 0;		// index from which to read next element
+	index_type write	= 0;		// index to which to write next element
+	level_type level	= 0;		// current amount of stored elements
+	alignas(T) unsigned char data[depth][sizeof(T)];
+
+	static constexpr index_type wrap(size_t idx)	{ return idx & mask; }
+	T* slot(size_t idx)								{ return std::launder(reinterpret_cast<T*>(data[idx])); }
+	const T* slot(size_t idx) const					{ return std::launder(reinterpret_cast<const T*>(data[idx])); }
+
+	void destroy(size_t amount)
+	{
+		if constexpr (!trivial)
+		{
+			for (size_t k = 0; k < amount; k++)
+				slot(wrap(read+k))->~T();
+		}
+	}
+
+public:
+	fifofast() = default;
+
+	fifofast(const fifofast &other)
+	{
+		for (size_t k = 0; k < other.level; k++)
+			emplace(other.peek(k));
+	}
+
+	fifofast(fifofast &&other) noexcept(std::is_nothrow_move_constructible_v<T>)
+	{
+		for (size_t k = 0; k < other.level; k++)
+			emplace(std::move(other.peek(k)));
+		other.reset();
+	}
+
+	fifofast& operator=(const fifofast &other)
+	{
+		if (this != &other)
+		{
+			reset();
+			for (size_t k = 0; k < other.level; k++)
+				emplace(other.peek(k));
+		}
+		return *this;
+	}
+
+	fifofast& operator=(fifofast &&other) noexcept(std::is_nothrow_move_constructible_v<T>)
+	{
+		if (this != &other)
+		{
+			reset();
+			for (size_t k = 0; k < other.level; k++)
+				emplace(std::move(other.peek(k)));
+			other.reset();
+		}
+		return *this;
+	}
+
+	~fifofast()								{ destroy(level); }
+
+
+	// returns the maximum amount of elements which can be stored in the fifo
+	static constexpr size_t mem_depth()		{ return depth; }
+	static constexpr size_t mem_mask()		{ return mask; }
+
+	// returns the amount of stored elements/ free space
+	level_type mem_level() const			{ return level; }
+	level_type mem_free() const				{ return depth - level; }
+
+	bool is_empty() const					{ return level == 0; }
+	bool is_full() const					{ return level > mask; }
+
+	// destroys all elements
+	void reset()
+	{
+		destroy(level);
+		read	= 0;
+		write	= 0;
+		level	= 0;
+	}
+
+
+	// constructs an element in place at the end of the fifo and returns a reference to it
+	// The user must ensure that space is available, see _fff_write_lite(...)
+	template <typename... Args>
+	T& emplace(Args&&... args)
+	{
+		T* element = ::new (static_cast<void*>(data[write])) T(std::forward<Args>(args)...);
+		write = wrap(write+1);
+		level++;
+		return *element;
+	}
+
+	// like emplace(...), but checks if space is available. Returns nullptr if full.
+	template <typename... Args>
+	T* try_emplace(Args&&... args)
+	{
+		if (is_full())
+			return nullptr;
+		return &emplace(std::forward<Args>(args)...);
+	}
+
+	// adds an element to the fifo, if space is available. Returns false if full (element dismissed).
+	bool push(const T &element)				{ return try_emplace(element) != nullptr; }
+	bool push(T &&element)					{ return try_emplace(std::move(element)) != nullptr; }
+
+	// removes the first element and returns it by moving it out of the fifo
+	// The user must ensure that the fifo is not empty, see _fff_read_lite(...)
+	T pop()
+	{
+		T* element = slot(read);
+		T result(std::move(*element));
+		if constexpr (!trivial)
+			element->~T();
+		read = wrap(read+1);
+		level--;
+		return result;
+	}
+
+	// moves the first element to 'dest', if available. Returns false if empty ('dest' unchanged).
+	bool try_pop(T &dest)
+	{
+		if (is_empty())
+			return false;
+		T* element = slot(read);
+		dest = std::move(*element);
+		if constexpr (!trivial)
+			element->~T();
+		read = wrap(read+1);
+		level--;
+		return true;
+	}
+
+	// allows accessing the stored elements as an array without removing them, see _fff_peek(...)
+	// Only elements below mem_level() exist; 'idx' is not checked.
+	T& peek(size_t idx)						{ return *slot(wrap(read+idx)); }
+	const T& peek(size_t idx) const			{ return *slot(wrap(read+idx)); }
+
+	// removes a certain number of elements or less, if not enough elements are available
+	void remove(size_t amount)
+	{
+		if (amount > level)
+			amount = level;
+		destroy(amount);
+		read	= wrap(read+amount);
+		level	-= amount;
+	}
+
+
+	// copies an array of elements to the fifo as long as space is available, see
+	// _fff_write_multiple(...). Returns the amount of elements written.
+	size_t write_multiple(const T *src, size_t n)
+	{
+		size_t amount = n < mem_free() ? n : mem_free();
+		if (amount == 0)
+			return 0;
+		if constexpr (trivial)
+		{
+			size_t first = amount < depth-write ? amount : depth-write;
+			std::memcpy(data[write], src, first*sizeof(T));
+			if (amount > first)
+				std::memcpy(data[0], src+first, (amount-first)*sizeof(T));
+			write = wrap(write+amount);
+			level += amount;
+		}
+		else
+		{
+			for (size_t k = 0; k < amount; k++)
+				emplace(src[k]);
+		}
+		return amount;
+	}
+
+	// moves up to n elements from the fifo to an array, see _fff_read_multiple(...)
+	// Returns the amount of elements read.
+	size_t read_multiple(T *dest, size_t n)
+	{
+		size_t amount = n < level ? n : level;
+		if (amount == 0)
+			return 0;
+		if constexpr (trivial)
+		{
+			size_t first = amount < depth-read ? amount : depth-read;
+			std::memcpy(dest, data[read], first*sizeof(T));
+			if (amount > first)
+				std::memcpy(dest+first, data[0], (amount-first)*sizeof(T));
+			read = wrap(read+amount);
+			level -= amount;
+		}
+		else
+		{
+			for (size_t k = 0; k < amount; k++)
+				dest[k] = pop();
+		}
+		return amount;
+	}
+};
+
+
+#endif /* FIFOFAST_HPP_ */
@@ -33,12 +33,41 @@ int main(void)
 	fifofast_test_macro_remove(0x60);
 	fifofast_test_macro_rebase(0x70);
 	fifofast_test_macro_write_multiple(0x80);
+	fifofast_test_macro_read_multiple(0x88);
+	fifofast_test_macro_span(0x8c);
+	fifofast_test_macro_spsc(0x90);
+	fifofast_test_macro_spsc_batch(0x98);
+	fifofast_test_macro_spsc_mixed(0x9c);
+	fifofast_test_macro_mpmc(0xa0);
+	fifofast_test_macro_mpsc(0xb0);
+	fifofast_test_macro_exact(0xd0);
+	fifofast_test_macro_options(0xd8);
+	fifofast_test_macro_record(0x10);
+	fifofast_test_macro_bip(0x20);
+	fifofast_test_macro_pq(0x30);
+	fifofast_test_macro_soa(0x40);
+	fifofast_test_macro_stats(0x50);
+	fifofast_test_macro_trace(0x60);
+	fifofast_test_macro_layout_cl();
+#ifdef __linux__
+	fifofast_test_macro_mirror(0xc8);
+	fifofast_test_macro_wait(0xe0);
+	fifofast_test_macro_event(0xe8);
+	fifofast_test_macro_latency(0xf0);
+	fifofast_test_macro_perf(0xf8);
+	fifofast_test_macro_trace_file(0x08);
+#endif
+#if FIFOFAST_TEST_CPP
+	fifofast_test_cpp_trivial(0x18);
+	fifofast_test_cpp_object(0x28);
+#endif
 	
 	fifofast_test_func_initial((fff_proto_t*)&fifo_uint8p);
 	fifofast_test_func_write((fff_proto_t*)&fifo_uint8p, 0x80);
 	fifofast_test_func_peek((fff_proto_t*)&fifo_uint8p, 0x90);
 	fifofast_test_func_remove_lite((fff_proto_t*)&fifo_uint8p, 0xa0);
 	fifofast_test_func_remove((fff_proto_t*)&fifo_uint8p, 0xb0);
+	fifofast_test_func_multiple((fff_proto_t*)&fifo_uint8p, 0xc0);
 	
 	UT_BREAK();
 
@@ -53,5 +53,41 @@ _fff_declare(frame_u, fifo_frame, 4);
 // declare an array (indicated by the suffix _a) of 5 fifos with 16 elements each.
 _fff_declare_a(uint8_t, fifo_array, 16, 5);
 
+// declare a fifo with exactly 5 elements (no rounding to 8); saves RAM for large fifos
+_fff_declare_exact(uint8_t, fifo_exact, 5);
+
+// declare a fifo, which always keeps the 4 newest elements and counts how many have been evicted
+_fff_declare(uint8_t, fifo_ring, 4, FFF_OPT_OVERWRITE | FFF_OPT_COUNT_DROPS);
+
+// declare a fifo, which keeps the 4 newest elements and counts elements, high-water level and
+// full/ empty transitions
+_fff_declare(uint8_t, fifo_stats, 4, FFF_OPT_OVERWRITE | FFF_OPT_STATS);
+
+// declare a fifo, whose accesses can be recorded for an offline replay
+_fff_declare(uint8_t, fifo_trace, 4, FFF_OPT_TRACE);
+
+// declare a fifo with 16 bytes for records (messages) of variable length
+_fff_declare_record(fifo_record, 16);
+
+// declare a bip buffer with 10 bytes, which always hands out contiguous blocks
+_fff_declare_bip(uint8_t, fifo_bip, 10);
+
+// declare a priority queue with 40 levels of 4 elements each; the next non-empty level is found in O(1)
+_fff_declare_pq(uint8_t, fifo_pq, 4, 40);
+
+// declare an array of 20 fifos with 4 elements each; all indices are stored apart from the data, so
+// a sweep over the fill levels reads only 20 bytes
+_fff_declare_soa(uint8_t, fifo_soa, 4, 20);
+
+// declare a lock-free fifo with 4 elements, which can be written by one producer (e.g. an ISR) and
+// read by one consumer (e.g. main) at the same time without atomic blocks
+_fff_declare_spsc(uint8_t, fifo_uint8_spsc, 4);
+
+// declare a lock-free fifo with 4 elements for any number of producers and consumers
+_fff_declare_mpmc(uint8_t, fifo_uint8_mpmc, 4);
+
+// declare a wait-free fifo with 4 elements for many producers (e.g. several ISRs) and one consumer
+_fff_declare_mpsc(uint8_t, fifo_uint8_mpsc, 4);
+
 
 #endif /* FIFOFAST_DEMO_H_ */
\ No newline at end of file
@@ -0,0 +1,806 @@
+/*
+ * fifofast_linux.h
+ *
+ * Created: 17.10.2026 09:14:52
+ *
+ * Description:
+ * Optional extensions of fifofast.h, which require a Linux kernel. They are kept in this separate
+ * file, so fifofast.h still compiles for any MCU. Include this file instead of fifofast.h.
+ *
+ * Mirrored fifos:
+ * The data array of a mirrored fifo is mapped twice back-to-back into the virtual memory. Every
+ * element written to 'data[idx]' also appears at 'data[idx + depth]', so the stored elements are
+ * always contiguous, even if they wrap around the end of the array. All regular macros can be used.
+ *
+ * Blocking access:
+ * Lock-free fifos declared with FFF_OPT_WAIT can be accessed with blocking macros, which spin for a
+ * short time and then put the thread to sleep on a futex until data/ space is available.
+ *
+ * Readiness notification:
+ * Fifos declared with FFF_OPT_EVENT own an eventfd, which becomes readable once the fill level
+ * reaches a threshold. It can be added to an epoll set together with sockets and other fds.
+ *
+ * Performance counters:
+ * The hardware counters of the kernel (perf_event_open) can be read around any region of code, e.g.
+ * all accesses to a certain fifo, and are accumulated per named region. If the kernel provides no
+ * counters (e.g. in containers or VMs), the macros still work and report the counts as unavailable.
+ *
+ * Trace files:
+ * The accesses of a fifo declared with FFF_OPT_TRACE can be written to a binary file, which can be
+ * replayed offline with other depths or fifo variants by bench/fifofast_replay.c.
+ */
+
+
+#ifndef FIFOFAST_LINUX_H_
+#define FIFOFAST_LINUX_H_
+
+#include "fifofast.h"
+
+#include <errno.h>			// required for 'errno'
+#include <fcntl.h>			// required for open()
+#include <limits.h>			// required for 'INT_MAX'
+#include <stdlib.h>			// required for malloc()
+#include <time.h>			// required for clock_gettime()
+#include <unistd.h>			// required for sysconf(), ftruncate(), lseek(), close(), syscall()
+#include <linux/futex.h>	// required for 'FUTEX_*'
+#include <linux/perf_event.h>	// required for 'perf_event_attr', 'PERF_*'
+#include <sys/eventfd.h>	// required for eventfd()
+#include <sys/ioctl.h>		// required for ioctl()
+#include <sys/mman.h>		// required for mmap()
+#include <sys/syscall.h>	// required for 'SYS_memfd_create', 'SYS_futex', 'SYS_perf_event_open'
+
+
+//////////////////////////////////////////////////////////////////////////
+// User Config
+//////////////////////////////////////////////////////////////////////////
+
+// defines the page size of the MMU. The data array of a mirrored fifo must start at a page boundary
+// and its size in bytes must be a multiple of this value. 4096 bytes fits x86 and most ARM systems.
+#define FIFOFAST_PAGE_SIZE				4096
+
+// defines the maximum amount of retries before a blocking macro puts the thread to sleep. The actual
+// limit adapts to about twice the amount of retries which were needed recently.
+#define FIFOFAST_WAIT_SPIN				200
+
+// defines the amount of records (8 bytes each) a trace file collects in RAM before they are
+// written to the file. The fifo access which fills the buffer writes it, so larger values make the
+// write less frequent, but longer.
+#define FIFOFAST_TRACE_BUFFER			4096
+
+
+//////////////////////////////////////////////////////////////////////////
+// Data Structures
+//////////////////////////////////////////////////////////////////////////
+
+// hardware events counted by fff_perf_t; index of 'count'
+#define FFF_PERF_CYCLES					0
+#define FFF_PERF_INSTRUCTIONS			1
+#define FFF_PERF_CACHE_MISSES			2
+#define FFF_PERF_BRANCH_MISSES			3
+#define FFF_PERF_EVENTS					4
+
+// version of the trace file format; increased whenever it changes
+#define FFF_TRACE_VERSION				1
+
+// header of a trace file written by _fff_trace_open(...), followed by any amount of records
+// (fff_trace_rec_t). All values are stored in the byte order of the recording machine.
+typedef struct
+{
+	char magic[4];					// "FFFT"
+	uint16_t version;				// FFF_TRACE_VERSION
+	uint16_t elem_size;				// bytes per element of the recorded fifo
+	uint32_t depth;					// amount of elements the recorded fifo can hold
+	uint32_t options;				// options (FFF_OPT_*) of the recorded fifo
+	double ns_per_tick;				// duration of a unit of FIFOFAST_TIMESTAMP() in ns, 0 if unknown
+} fff_trace_header_t;
+
+// hardware counters of a named region, see _fff_perf_open(...)
+typedef struct
+{
+	const char *name;				// name of the fifo or region the counts are attributed to
+	int32_t fd[FFF_PERF_EVENTS];	// perf_event file descriptors, -1 if the event is not available
+	int32_t leader;					// fd of the group leader if all events are read at once, else -1
+	uint64_t start[FFF_PERF_EVENTS][3];	// count, time enabled and running at the start of the region
+	uint64_t count[FFF_PERF_EVENTS];	// sum of the counts of all regions
+	uint64_t ops;					// sum of the operations of all regions
+} fff_perf_t;
+
+
+//////////////////////////////////////////////////////////////////////////
+// Function Declarations (Internal)
+//////////////////////////////////////////////////////////////////////////
+
+static inline int fff_mirror_map(void *data, size_t size);
+
+// progress of a single blocking macro call
+typedef struct
+{
+	struct timespec deadline;		// CLOCK_MONOTONIC
+	uint32_t seq;					// value of the futex word before the last check
+	uint32_t count;					// amount of retries while spinning
+	uint32_t limit;					// maximum amount of retries while spinning
+	uint8_t phase;					// 0: first check, 1: spinning, 2: registered as waiter
+} fff_wait_ctx_t;
+
+static inline uint8_t fff_wait_next(fff_wait_t *wait, uint8_t side, fff_wait_ctx_t *ctx, int64_t timeout_ns);
+static inline void fff_wait_done(fff_wait_t *wait, uint8_t side, fff_wait_ctx_t *ctx, uint8_t success);
+static inline void fff_wait_wake(fff_wait_t *wait, uint8_t side);
+
+static inline int fff_event_open(fff_event_t *event, uint32_t threshold);
+static inline void fff_event_close(fff_event_t *event);
+static inline void fff_event_notify(fff_event_t *event, size_t level);
+static inline void fff_event_rearm(fff_event_t *event);
+
+static inline int fff_trace_open(fff_trace_t *trace, const char *path, fff_trace_header_t *header);
+static inline void fff_trace_flush(fff_trace_t *trace);
+static inline uint32_t fff_trace_close(fff_trace_t *trace);
+static inline double fff_trace_ns_per_tick(void);
+
+static inline uint8_t fff_perf_open(fff_perf_t *perf, const char *name, uint8_t inherit);
+static inline void fff_perf_close(fff_perf_t *perf);
+static inline uint8_t fff_perf_read(const fff_perf_t *perf, uint64_t value[FFF_PERF_EVENTS][3]);
+static inline void fff_perf_begin(fff_perf_t *perf);
+static inline void fff_perf_end(fff_perf_t *perf, uint64_t ops);
+static inline double fff_perf_per_op(const fff_perf_t *perf, uint8_t event);
+
+
+//////////////////////////////////////////////////////////////////////////
+// mirrored fifos (_fff_*_mirror)
+//////////////////////////////////////////////////////////////////////////
+
+// declares a mirrored fifo. It has the same members as a fifo declared by _fff_declare(...), so all
+// function-like macros (_fff_write, _fff_read, _fff_peek, _fff_remove, ...) can be used as usual.
+// Additionally the member 'mirror' reserves the address space for the second mapping.
+//
+// With the mirror in place '&_fff_peek(_id, 0)' always points to _fff_mem_level(_id) contiguous
+// elements, which can be passed directly to memchr(), strtol(), write() and so on. _fff_rebase(...)
+// is not needed for mirrored fifos and does nothing.
+//
+// _id:		C conform identifier
+// _type:	any C type except pointers and structs. To store pointers or structs use typedef first
+// _depth:	maximum amount of elements, see _fff_declare(...). _depth*sizeof(_type) must be a
+//			multiple of 'FIFOFAST_PAGE_SIZE'.
+#define _fff_declare_mirror(_type, _id, _depth)							\
+struct _FFF_NAME_STRUCT(_id) {											\
+	_FFF_GET_TYPE(_depth) read;											\
+	_FFF_GET_TYPE(_depth) write;										\
+	_FFF_GET_TYPE(_depth+1) level;										\
+	_type data[_FFF_GET_ARRAYDEPTH(_depth)]								\
+		__attribute__((aligned(FIFOFAST_PAGE_SIZE)));					\
+	_type mirror[_FFF_GET_ARRAYDEPTH(_depth)];							\
+	_FFF_MEMBERS_OPT(_FFF_OPT_MIRROR, _FFF_GET_ARRAYDEPTH(_depth))		\
+	_Static_assert(sizeof(_type[_FFF_GET_ARRAYDEPTH(_depth)]) % FIFOFAST_PAGE_SIZE == 0,	\
+		"size of a mirrored fifo must be a multiple of FIFOFAST_PAGE_SIZE");	\
+} _id
+
+#define _fff_init_mirror(_id)											\
+struct _FFF_NAME_STRUCT(_id) _id =										\
+{																		\
+	0,																	\
+	0,																	\
+	0,																	\
+	{},																	\
+	{}																	\
+}
+
+// maps the data array of a mirrored fifo a second time directly behind itself
+// This function must be called once before the fifo is used, e.g. at the start of main(). Stored
+// data is preserved.
+// Returns 0 on success. Otherwise -1 is returned, 'errno' is set and the fifo is not mirrored.
+// If the page size of the system is not a divisor of 'FIFOFAST_PAGE_SIZE', 'errno' is EINVAL.
+// _id:		C conform identifier
+#define _fff_mirror_map(_id)			fff_mirror_map(_id.data, sizeof(_id.data))
+
+// the compiler assumes 'data' and 'mirror' never overlap. After elements have been written through a
+// pointer reaching into the mirror (e.g. derived from &_fff_peek(...)), call this macro before they
+// are accessed with the regular macros again. Reading through the mirror needs no sync.
+// _id:		C conform identifier
+#define _fff_mirror_sync(_id)			__asm__ __volatile__("" : : "m"(_id) : "memory")
+
+
+//////////////////////////////////////////////////////////////////////////
+// blocking macros for lock-free fifos (_fff_*_wait)
+//////////////////////////////////////////////////////////////////////////
+
+// The blocking macros retry the non-blocking macro of the same name (e.g. _fff_spsc_read(...) for
+// _fff_spsc_read_wait(...)) until it succeeds or the timeout expires. At first the thread spins;
+// the spin limit adapts to the amount of retries the last calls needed, up to FIFOFAST_WAIT_SPIN.
+// Then the thread registers as a waiter and sleeps on the futex word 'wait.seq[side]'.
+// After each successful access the other side is woken up, but the futex syscall is only issued if
+// a thread has registered as a waiter, so the fast path costs a single memory fence.
+// Threads which sleep are only woken up by the blocking macros, so ALL producers and consumers of a
+// fifo must use them. Use a timeout of 0 for a non-blocking access, which still wakes up the other
+// side.
+// The fifo must be declared with FFF_OPT_WAIT, e.g. _fff_declare_spsc(uint8_t, fifo, 64, FFF_OPT_WAIT).
+
+// values for 'timeout_ns'
+#define FFF_WAIT_NONE					0		// don't block, like the non-blocking macros
+#define FFF_WAIT_FOREVER				(-1)	// block until the access succeeds
+
+// sides of a fifo, see fff_wait_t
+#define FFF_WAIT_DATA					0
+#define FFF_WAIT_SPACE					1
+
+#define _FFF_WAIT(_id, _side, _try, timeout_ns)							\
+({																		\
+	_Static_assert(_fff_options(_id) & FFF_OPT_WAIT, "fifo must be declared with FFF_OPT_WAIT");	\
+	uint8_t _wait_return;												\
+	int64_t _wait_timeout = (timeout_ns);								\
+	fff_wait_ctx_t _wait_ctx = {.phase = 0};							\
+	while (!(_wait_return = (_try))										\
+		&& fff_wait_next(&_id.wait[0], _side, &_wait_ctx, _wait_timeout));	\
+	fff_wait_done(&_id.wait[0], _side, &_wait_ctx, _wait_return);		\
+	_wait_return;														\
+})
+
+// adds an element to the fifo and waits up to 'timeout_ns' nanoseconds for space, if it is full.
+// Returns !0 if the element was written, 0 on timeout (element dismissed).
+// _id:		C conform identifier
+// newdata:	data to be written; evaluated once per retry
+// timeout_ns:	maximum time to wait in ns, FFF_WAIT_NONE or FFF_WAIT_FOREVER
+#define _fff_spsc_write_wait(_id, newdata, timeout_ns)					\
+	_FFF_WAIT(_id, FFF_WAIT_SPACE, _fff_spsc_write(_id, newdata), timeout_ns)
+#define _fff_mpmc_write_wait(_id, newdata, timeout_ns)					\
+	_FFF_WAIT(_id, FFF_WAIT_SPACE, _fff_mpmc_write(_id, newdata), timeout_ns)
+#define _fff_mpsc_write_wait(_id, newdata, timeout_ns)					\
+	_FFF_WAIT(_id, FFF_WAIT_SPACE, _fff_mpsc_write(_id, newdata), timeout_ns)
+
+// copies the next element to 'data_p' and waits up to 'timeout_ns' nanoseconds for data, if the
+// fifo is empty. Returns !0 if an element was read, 0 on timeout ('*data_p' is not modified then).
+// _id:		C conform identifier
+// data_p:	pointer to the destination, must be of type 'typeof(_id.data[0])*'
+// timeout_ns:	maximum time to wait in ns, FFF_WAIT_NONE or FFF_WAIT_FOREVER
+#define _fff_spsc_read_wait(_id, data_p, timeout_ns)					\
+	_FFF_WAIT(_id, FFF_WAIT_DATA, _fff_spsc_read(_id, data_p), timeout_ns)
+#define _fff_mpmc_read_wait(_id, data_p, timeout_ns)					\
+	_FFF_WAIT(_id, FFF_WAIT_DATA, _fff_mpmc_read(_id, data_p), timeout_ns)
+#define _fff_mpsc_read_wait(_id, data_p, timeout_ns)					\
+	_FFF_WAIT(_id, FFF_WAIT_DATA, _fff_mpsc_read(_id, data_p), timeout_ns)
+
+
+//////////////////////////////////////////////////////////////////////////
+// readiness notification (_fff_*event*)
+//////////////////////////////////////////////////////////////////////////
+
+// The eventfd of a fifo declared with FFF_OPT_EVENT is signaled once, when the fill level reaches
+// the threshold, and then stays silent until the consumer acknowledges it. Thus a burst of any
+// length causes a single wake-up of the event loop (edge-triggered, coalesced). After writing, the
+// producer calls _fff_event_notify(...), which costs a memory fence and a compare while the event
+// is already pending. When epoll reports the eventfd as readable, the consumer reads the fifo and
+// then calls _fff_event_ack(...). If the fill level has reached the threshold again meanwhile, the
+// eventfd is signaled again right away, so no data is forgotten.
+// Each fifo variant has its own notify/ack macros, as they need its fill level. The macros are as
+// thread-safe as the fifo itself: use the lock-free variants if producer and consumer run in
+// different threads.
+//
+// Example:
+//	_fff_event_open(fifo, 1);
+//	epoll_ctl(epfd, EPOLL_CTL_ADD, _fff_event_fd(fifo), &(struct epoll_event){.events = EPOLLIN});
+
+// creates the eventfd of a fifo. Must be called once before the fifo is used.
+// Returns 0 on success. Otherwise -1 is returned and 'errno' is set.
+// _id:			C conform identifier
+// threshold:	fill level at which the eventfd becomes readable, 1 signals empty -> non-empty
+#define _fff_event_open(_id, threshold)									\
+({																		\
+	_Static_assert(_fff_options(_id) & FFF_OPT_EVENT, "fifo must be declared with FFF_OPT_EVENT");	\
+	fff_event_open(&_id.event[0], (threshold));							\
+})
+
+// closes the eventfd of a fifo; no further notifications are sent
+// _id:		C conform identifier
+#define _fff_event_close(_id)			fff_event_close(&_id.event[0])
+
+// returns the eventfd of a fifo, e.g. for epoll_ctl()
+// _id:		C conform identifier
+#define _fff_event_fd(_id)				(_id.event[0].fd)
+
+// PRODUCER: signals the eventfd, if the fill level has reached the threshold and the last signal
+// has been acknowledged. Call after each write or once after a batch of writes.
+// _id:		C conform identifier
+#define _fff_event_notify(_id)			fff_event_notify(&_id.event[0], _fff_mem_level(_id))
+#define _fff_spsc_event_notify(_id)		fff_event_notify(&_id.event[0], _fff_spsc_mem_level(_id))
+#define _fff_mpmc_event_notify(_id)		fff_event_notify(&_id.event[0], _fff_mpmc_mem_level(_id))
+#define _fff_mpsc_event_notify(_id)		fff_event_notify(&_id.event[0], _fff_mpsc_mem_level(_id))
+
+// CONSUMER: acknowledges the last signal, call after reading the fifo. Clears the eventfd and allows
+// the next signal. If the fill level is still at the threshold, the eventfd is signaled again
+// immediately.
+// _id:		C conform identifier
+#define _fff_event_ack(_id)												\
+do{																		\
+	fff_event_rearm(&_id.event[0]);										\
+	_fff_event_notify(_id);												\
+}while(0)
+#define _fff_spsc_event_ack(_id)										\
+do{																		\
+	fff_event_rearm(&_id.event[0]);										\
+	_fff_spsc_event_notify(_id);										\
+}while(0)
+#define _fff_mpmc_event_ack(_id)										\
+do{																		\
+	fff_event_rearm(&_id.event[0]);										\
+	_fff_mpmc_event_notify(_id);										\
+}while(0)
+#define _fff_mpsc_event_ack(_id)										\
+do{																		\
+	fff_event_rearm(&_id.event[0]);										\
+	_fff_mpsc_event_notify(_id);										\
+}while(0)
+
+
+//////////////////////////////////////////////////////////////////////////
+// trace files (_fff_trace_*)
+//////////////////////////////////////////////////////////////////////////
+
+// Every access of a fifo declared with FFF_OPT_TRACE is recorded in a buffer of FIFOFAST_TRACE_BUFFER
+// records, which is appended to the file whenever it is full. A record takes 8 bytes, so a fifo
+// accessed a million times per second writes about 8 MB/s.
+//
+// Example:
+//	_fff_declare(msg_t, fifo_rx, 64, FFF_OPT_TRACE);
+//	fff_trace_t trace_rx;
+//	if (_fff_trace_open(fifo_rx, trace_rx, "rx.trace") != 0)
+//		perror("trace");
+//	...
+//	_fff_trace_close(fifo_rx, trace_rx);
+
+// creates (or truncates) the trace file 'path' and attaches a recorder writing to it to the fifo.
+// Returns 0 on success, -1 if the file can't be created (see errno); the fifo isn't traced then.
+// _id:		C conform identifier
+// trace:	variable of type fff_trace_t, must exist until _fff_trace_close(...)
+// path:	name of the file
+#define _fff_trace_open(_id, trace, path)								\
+({																		\
+	fff_trace_header_t _tr_h = {{'F', 'F', 'F', 'T'}, FFF_TRACE_VERSION,	\
+		_fff_data_size(_id), _fff_mem_depth(_id), _fff_options(_id), 0};	\
+	int _tr_r = fff_trace_open(&(trace), (path), &_tr_h);				\
+	if (_tr_r == 0)														\
+		_fff_trace_attach(_id, trace);									\
+	_tr_r;																\
+})
+
+// detaches the recorder, writes the remaining records and closes the file. Returns the amount of
+// records lost because they couldn't be written.
+// _id:		C conform identifier
+// trace:	variable of type fff_trace_t, which has been opened with _fff_trace_open(...)
+#define _fff_trace_close(_id, trace)									\
+({																		\
+	_fff_trace_detach(_id);												\
+	fff_trace_close(&(trace));											\
+})
+
+
+//////////////////////////////////////////////////////////////////////////
+// performance counters (_fff_perf_*)
+//////////////////////////////////////////////////////////////////////////
+
+// A region is any code between _fff_perf_begin(...) and _fff_perf_end(...), e.g. a loop accessing a
+// fifo. The counts of all regions using the same fff_perf_t are accumulated together with the amount
+// of operations passed to _fff_perf_end(...), so _fff_perf_per_op(...) returns the average count per
+// operation. Only user space is counted. The counters are read with a syscall each, which costs about
+// 1 us, so a region should contain many operations.
+// If the kernel does not provide an event (e.g. in a container or VM), its count is unavailable
+// and _fff_perf_per_op(...) returns a negative value; all other macros have no effect then.
+//
+// Example:
+//	fff_perf_t perf_rx;
+//	_fff_perf_open(perf_rx, fifo_rx);
+//	_fff_perf_begin(perf_rx);
+//	for (uint8_t k = 0; k < 100; k++)
+//		_fff_write(fifo_rx, k);
+//	_fff_perf_end(perf_rx, 100);
+//	printf("%s: %.1f cycles/op\n", perf_rx.name, _fff_perf_per_op(perf_rx, FFF_PERF_CYCLES));
+
+// opens the counters of a region named after the fifo '_id'. Only the calling thread is counted; use
+// fff_perf_open(...) with 'inherit' = 1 to count threads created afterwards as well.
+// Without 'inherit' the events are opened as a group, so they count exactly the same instructions
+// and are read with a single syscall. Events which don't fit into the hardware counters together
+// with the others are not available then.
+// Returns the amount of available events, 0 if the kernel provides no counters.
+// perf:	variable of type fff_perf_t
+// _id:		C conform identifier of the fifo the counts are attributed to
+#define _fff_perf_open(perf, _id)		fff_perf_open(&(perf), #_id, 0)
+
+// closes all counters; _fff_perf_per_op(...) reports them as not available afterwards, but the
+// sums in 'count' and 'ops' are kept
+// perf:	variable of type fff_perf_t
+#define _fff_perf_close(perf)			fff_perf_close(&(perf))
+
+// starts a region
+// perf:	variable of type fff_perf_t
+#define _fff_perf_begin(perf)			fff_perf_begin(&(perf))
+
+// ends a region and adds its counts and 'ops' operations to the sums
+// perf:	variable of type fff_perf_t
+// ops:		amount of operations within the region
+#define _fff_perf_end(perf, ops)		fff_perf_end(&(perf), (ops))
+
+// returns the average count of 'event' (FFF_PERF_*) per operation, < 0 if not available
+// perf:	variable of type fff_perf_t
+// event:	FFF_PERF_CYCLES, FFF_PERF_INSTRUCTIONS, FFF_PERF_CACHE_MISSES or FFF_PERF_BRANCH_MISSES
+#define _fff_perf_per_op(perf, event)	fff_perf_per_op(&(perf), (event))
+
+// clears the accumulated counts
+// perf:	variable of type fff_perf_t
+#define _fff_perf_reset(perf)											\
+do{																		\
+	memset((perf).count, 0, sizeof((perf).count));						\
+	(perf).ops = 0;														\
+}while(0)
+
+
+//////////////////////////////////////////////////////////////////////////
+// Inline functions
+//////////////////////////////////////////////////////////////////////////
+
+static inline int fff_mirror_map(void *data, size_t size)
+{
+	// the layout of the fifo is based on FIFOFAST_PAGE_SIZE, so larger pages would map other members
+	long page = sysconf(_SC_PAGESIZE);
+	if (page <= 0 || FIFOFAST_PAGE_SIZE % page != 0 || size % page != 0 || (uintptr_t)data % page != 0)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	int fd = syscall(SYS_memfd_create, "fifofast", 1u /* MFD_CLOEXEC */);
+	if (fd < 0)
+		return -1;
+
+	// preserve current content, then replace both halves with shared mappings of the same file
+	int result = -1;
+	if (ftruncate(fd, size) == 0 && pwrite(fd, data, size, 0) == (ssize_t)size
+		&& mmap(data, size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0) != MAP_FAILED
+		&& mmap((uint8_t*)data + size, size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, fd, 0) != MAP_FAILED)
+	{
+		result = 0;
+	}
+
+	int err = errno;
+	close(fd);
+	errno = err;
+	return result;
+}
+
+// called after each failed attempt of a blocking macro. Spins, registers as waiter or sleeps and
+// returns !0 if the access shall be retried, 0 if the timeout has expired.
+static inline uint8_t fff_wait_next(fff_wait_t *wait, uint8_t side, fff_wait_ctx_t *ctx, int64_t timeout_ns)
+{
+	if (ctx->phase == 0)
+	{
+		if (timeout_ns == 0)
+			return 0;
+		if (timeout_ns > 0)
+		{
+			clock_gettime(CLOCK_MONOTONIC, &ctx->deadline);
+			int64_t nsec = ctx->deadline.tv_nsec + timeout_ns % 1000000000;
+			ctx->deadline.tv_sec += timeout_ns / 1000000000 + nsec / 1000000000;
+			ctx->deadline.tv_nsec = nsec % 1000000000;
+		}
+		uint32_t spin = __atomic_load_n(&wait->spin[side], __ATOMIC_RELAXED);
+		ctx->limit = _min(2*spin + 10, FIFOFAST_WAIT_SPIN);
+		ctx->count = 0;
+		ctx->phase = 1;
+	}
+	
+	if (ctx->phase == 1)
+	{
+		if (ctx->count < ctx->limit)
+		{
+			ctx->count++;
+		#if defined(__x86_64__) || defined(__i386__)
+			__builtin_ia32_pause();
+		#elif defined(__aarch64__) || defined(__arm__)
+			__asm__ __volatile__("yield");
+		#endif
+			return 1;
+		}
+		
+		// register before the last check, so a producer/ consumer can't miss this thread
+		__atomic_fetch_add(&wait->waiters[side], 1, __ATOMIC_SEQ_CST);
+		ctx->seq = __atomic_load_n(&wait->seq[side], __ATOMIC_SEQ_CST);
+		ctx->phase = 2;
+		return 1;
+	}
+	
+	// sleeps only if 'seq' is unchanged since the last check; an absolute deadline ignores wake-ups
+	// which did not help this thread
+	long result = syscall(SYS_futex, &wait->seq[side], FUTEX_WAIT_BITSET_PRIVATE, ctx->seq,
+		(timeout_ns > 0) ? &ctx->deadline : NULL, NULL, FUTEX_BITSET_MATCH_ANY);
+	if (result != 0 && errno == ETIMEDOUT)
+		return 0;
+	ctx->seq = __atomic_load_n(&wait->seq[side], __ATOMIC_SEQ_CST);
+	return 1;
+}
+
+// called once at the end of a blocking macro. Unregisters the thread, updates the spin limit and
+// wakes up the other side on success.
+static inline void fff_wait_done(fff_wait_t *wait, uint8_t side, fff_wait_ctx_t *ctx, uint8_t success)
+{
+	if (ctx->phase != 0)
+	{
+		if (ctx->phase == 2)
+		{
+			__atomic_fetch_sub(&wait->waiters[side], 1, __ATOMIC_RELAXED);
+			ctx->count = ctx->limit;
+		}
+		// moving average, as used by adaptive mutexes
+		int32_t spin = __atomic_load_n(&wait->spin[side], __ATOMIC_RELAXED);
+		spin += ((int32_t)ctx->count - spin) / 8;
+		__atomic_store_n(&wait->spin[side], spin, __ATOMIC_RELAXED);
+	}
+	
+	if (success)
+		fff_wait_wake(wait, !side);
+}
+
+// wakes up all threads waiting on 'side'. The syscall is skipped, if no thread has registered.
+static inline void fff_wait_wake(fff_wait_t *wait, uint8_t side)
+{
+	// pairs with the registration in fff_wait_next(...): either the waiter sees the new index or
+	// this thread sees the waiter
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&wait->waiters[side], __ATOMIC_RELAXED))
+	{
+		__atomic_fetch_add(&wait->seq[side], 1, __ATOMIC_SEQ_CST);
+		syscall(SYS_futex, &wait->seq[side], FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+	}
+}
+
+static inline int fff_event_open(fff_event_t *event, uint32_t threshold)
+{
+	int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (fd < 0)
+		return -1;
+	
+	event->fd = fd;
+	event->threshold = threshold ? threshold : 1;
+	__atomic_store_n(&event->armed, 1, __ATOMIC_SEQ_CST);
+	return 0;
+}
+
+static inline void fff_event_close(fff_event_t *event)
+{
+	__atomic_store_n(&event->armed, 0, __ATOMIC_SEQ_CST);
+	close(event->fd);
+	event->fd = -1;
+	event->threshold = 0;
+}
+
+static inline void fff_event_notify(fff_event_t *event, size_t level)
+{
+	if (level >= event->threshold)
+	{
+		// pairs with fff_event_rearm(...): either the consumer sees the new level or this thread
+		// sees the event armed
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&event->armed, __ATOMIC_RELAXED)
+			&& __atomic_exchange_n(&event->armed, 0, __ATOMIC_ACQ_REL))
+		{
+			uint64_t one = 1;
+			if (write(event->fd, &one, sizeof(one))) {}
+		}
+	}
+}
+
+static inline void fff_event_rearm(fff_event_t *event)
+{
+	// 'threshold' is 0 as long as no eventfd is open
+	if (event->threshold == 0)
+		return;
+	
+	uint64_t count;
+	if (read(event->fd, &count, sizeof(count))) {}
+	__atomic_store_n(&event->armed, 1, __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline int fff_trace_open(fff_trace_t *trace, const char *path, fff_trace_header_t *header)
+{
+	fff_trace_rec_t *rec = malloc(FIFOFAST_TRACE_BUFFER * sizeof(fff_trace_rec_t));
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	
+	header->ns_per_tick = fff_trace_ns_per_tick();
+	if (rec == NULL || fd < 0 || write(fd, header, sizeof(*header)) != sizeof(*header))
+	{
+		int error = (rec == NULL) ? ENOMEM : errno;
+		free(rec);
+		if (fd >= 0)
+			close(fd);
+		errno = error;
+		return -1;
+	}
+	
+	fff_trace_init(trace, rec, FIFOFAST_TRACE_BUFFER);
+	trace->flush	= fff_trace_flush;
+	trace->ctx		= fd;
+	return 0;
+}
+
+// writes all collected records to the file; records which can't be written are counted as lost.
+// Short writes are continued. If the write fails, a partially written record is cut off again, so
+// the file always ends with a whole record.
+static inline void fff_trace_flush(fff_trace_t *trace)
+{
+	size_t bytes = trace->count * sizeof(fff_trace_rec_t);
+	size_t done = 0;
+	while (done < bytes)
+	{
+		ssize_t written = write(trace->ctx, (uint8_t*)trace->rec + done, bytes - done);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			break;
+		done += written;
+	}
+	if (done != bytes)
+	{
+		off_t partial = done % sizeof(fff_trace_rec_t);
+		if (partial != 0)
+		{
+			off_t end = lseek(trace->ctx, -partial, SEEK_CUR);
+			if (end >= 0)
+				(void)!ftruncate(trace->ctx, end);
+		}
+		trace->lost += trace->count - done / sizeof(fff_trace_rec_t);
+	}
+	trace->count = 0;
+}
+
+static inline uint32_t fff_trace_close(fff_trace_t *trace)
+{
+	fff_trace_flush(trace);
+	close(trace->ctx);
+	free(trace->rec);
+	trace->rec		= NULL;
+	trace->size		= 0;
+	trace->flush	= NULL;
+	return trace->lost;
+}
+
+// measures the duration of a unit of FIFOFAST_TIMESTAMP() against CLOCK_MONOTONIC for 1 ms
+static inline double fff_trace_ns_per_tick(void)
+{
+	struct timespec t0, t1;
+	fff_time_t start = FIFOFAST_TIMESTAMP(), ticks;
+	int64_t ns;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	do
+	{
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		ns = (int64_t)(t1.tv_sec - t0.tv_sec)*1000000000 + (t1.tv_nsec - t0.tv_nsec);
+	} while (ns < 1000000);
+	ticks = FIFOFAST_TIMESTAMP() - start;
+	return ticks ? (double)ns / ticks : 0;
+}
+
+static inline uint8_t fff_perf_open(fff_perf_t *perf, const char *name, uint8_t inherit)
+{
+	static const uint64_t config[FFF_PERF_EVENTS] =
+	{
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES
+	};
+	uint8_t available = 0;
+	
+	memset(perf, 0, sizeof(*perf));
+	perf->name		= name;
+	perf->leader	= -1;
+	for (uint8_t k = 0; k < FFF_PERF_EVENTS; k++)
+	{
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size			= sizeof(attr);
+		attr.type			= PERF_TYPE_HARDWARE;
+		attr.config			= config[k];
+		attr.inherit		= inherit;
+		attr.exclude_kernel	= 1;
+		attr.exclude_hv		= 1;
+		attr.read_format	= PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		
+		// groups can't be inherited, so each event is a separate counter then. Otherwise the first
+		// available event becomes the group leader, which reads the counts of all events. It starts
+		// disabled, as events added to a running group are only counted after it is rescheduled.
+		if (!inherit)
+		{
+			attr.read_format	|= PERF_FORMAT_GROUP;
+			attr.disabled		= (perf->leader < 0);
+		}
+		perf->fd[k] = syscall(SYS_perf_event_open, &attr, 0, -1, perf->leader, PERF_FLAG_FD_CLOEXEC);
+		if (perf->fd[k] < 0)
+			perf->fd[k] = -1;
+		else
+		{
+			if (!inherit && perf->leader < 0)
+				perf->leader = perf->fd[k];
+			available++;
+		}
+	}
+	if (perf->leader >= 0)
+		ioctl(perf->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	return available;
+}
+
+static inline void fff_perf_close(fff_perf_t *perf)
+{
+	for (uint8_t k = 0; k < FFF_PERF_EVENTS; k++)
+	{
+		if (perf->fd[k] >= 0)
+			close(perf->fd[k]);
+		perf->fd[k] = -1;
+	}
+	perf->leader = -1;
+}
+
+// reads the raw count, time enabled and time running of all available events. Returns 0 if a
+// counter can't be read.
+static inline uint8_t fff_perf_read(const fff_perf_t *perf, uint64_t value[FFF_PERF_EVENTS][3])
+{
+	if (perf->leader >= 0)
+	{
+		uint64_t group[3+FFF_PERF_EVENTS];	// amount of events, time enabled, time running, counts
+		uint8_t idx = 0;
+		if (read(perf->leader, group, sizeof(group)) < (ssize_t)(3*sizeof(uint64_t)))
+			return 0;
+		for (uint8_t k = 0; k < FFF_PERF_EVENTS; k++)
+		{
+			// the group returns the counts in the order the events have been opened
+			if (perf->fd[k] >= 0 && idx < group[0])
+			{
+				value[k][0] = group[3+idx++];
+				value[k][1] = group[1];
+				value[k][2] = group[2];
+			}
+		}
+		return 1;
+	}
+	for (uint8_t k = 0; k < FFF_PERF_EVENTS; k++)
+	{
+		if (perf->fd[k] >= 0 && read(perf->fd[k], value[k], sizeof(value[k])) != sizeof(value[k]))
+			return 0;
+	}
+	return 1;
+}
+
+static inline void fff_perf_begin(fff_perf_t *perf)
+{
+	uint64_t value[FFF_PERF_EVENTS][3];
+	if (fff_perf_read(perf, value))
+		memcpy(perf->start, value, sizeof(value));
+}
+
+// The differences of the raw values are taken first and only the difference of the count is scaled:
+// if the kernel had to share the hardware counters with other events, the count of the region is
+// extrapolated to the time the counter was enabled within the region. Regions which can't be read
+// are dismissed completely.
+static inline void fff_perf_end(fff_perf_t *perf, uint64_t ops)
+{
+	uint64_t value[FFF_PERF_EVENTS][3];
+	if (!fff_perf_read(perf, value))
+		return;
+	for (uint8_t k = 0; k < FFF_PERF_EVENTS; k++)
+	{
+		if (perf->fd[k] < 0)
+			continue;
+		uint64_t count		= value[k][0] - perf->start[k][0];
+		uint64_t enabled	= value[k][1] - perf->start[k][1];
+		uint64_t running	= value[k][2] - perf->start[k][2];
+		if (running != 0 && running < enabled)
+			count = (uint64_t)((double)count * enabled / running);
+		perf->count[k] += count;
+	}
+	perf->ops += ops;
+}
+
+static inline double fff_perf_per_op(const fff_perf_t *perf, uint8_t event)
+{
+	if (event >= FFF_PERF_EVENTS || perf->fd[event] < 0 || perf->ops == 0)
+		return -1;
+	return (double)perf->count[event] / perf->ops;
+}
+
+
+#endif /* FIFOFAST_LINUX_H_ */
@@ -7,6 +7,11 @@
 
 #include "fifofast_test.h"
 
+#ifdef __linux__
+#include "fifofast_linux.h"
+#include <pthread.h>		// required for pthread_create()
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 // Initialize fifos for global access
 ///////////////////////////////////////////////////////////////////////////////
@@ -17,6 +22,48 @@ _fff_init_p(fifo_uint8p);
 _fff_init(fifo_int16);
 _fff_init(fifo_frame);
 _fff_init_a(fifo_array, 5);
+_fff_init(fifo_exact);
+_fff_init(fifo_ring);
+_fff_init(fifo_stats);
+_fff_init(fifo_trace);
+_fff_init_record(fifo_record);
+_fff_init_bip(fifo_bip);
+_fff_init_pq(fifo_pq);
+_fff_init_soa(fifo_soa);
+_fff_init_spsc(fifo_uint8_spsc);
+_fff_init_mpmc(fifo_uint8_mpmc);
+_fff_init_mpsc(fifo_uint8_mpsc);
+
+// cache line aligned fifos are only declared to check their layout; no RAM is used
+extern _fff_declare_spsc_cl(uint8_t, fifo_spsc_cl, 4);
+extern _fff_declare_mpmc_cl(uint8_t, fifo_mpmc_cl, 4);
+extern _fff_declare_mpsc_cl(uint8_t, fifo_mpsc_cl, 4);
+
+#ifdef __linux__
+// mirrored fifo, smallest size possible (one page)
+_fff_declare_mirror(uint8_t, fifo_mirror, FIFOFAST_PAGE_SIZE);
+_fff_init_mirror(fifo_mirror);
+
+// lock-free fifos with state for the blocking macros
+_fff_declare_spsc(uint8_t, fifo_spsc_wait, 4, FFF_OPT_WAIT);
+_fff_init_spsc(fifo_spsc_wait);
+_fff_declare_mpmc(uint8_t, fifo_mpmc_wait, 4, FFF_OPT_WAIT);
+_fff_init_mpmc(fifo_mpmc_wait);
+_fff_declare_mpsc(uint8_t, fifo_mpsc_wait, 4, FFF_OPT_WAIT);
+_fff_init_mpsc(fifo_mpsc_wait);
+
+// fifo with an eventfd for epoll
+_fff_declare(uint8_t, fifo_event, 8, FFF_OPT_EVENT);
+_fff_init(fifo_event);
+_fff_declare_mpmc(uint8_t, fifo_mpmc_event, 4, FFF_OPT_EVENT);
+_fff_init_mpmc(fifo_mpmc_event);
+_fff_declare_mpsc(uint8_t, fifo_mpsc_event, 4, FFF_OPT_EVENT);
+_fff_init_mpsc(fifo_mpsc_event);
+
+// fifo with latency histogram; needs about 2KB RAM with 64bit timestamps
+_fff_declare(uint8_t, fifo_latency, 4, FFF_OPT_LATENCY);
+_fff_init(fifo_latency);
+#endif
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -72,6 +119,18 @@ void fifofast_test_macro_write(uint8_t startvalue)
 	UT_ASSERT(_fff_mem_free(fifo_uint8)		== 4);
 	UT_ASSERT(_fff_is_empty(fifo_uint8)		!= 0);
 	UT_ASSERT(_fff_is_full(fifo_uint8)		== 0);
+	
+	// performance budget, includes writes to a full fifo
+	for (uint8_t k = 0; k < 8; k++)
+	{
+		UT_TIME_BEGIN("_fff_write");
+		_fff_write(fifo_uint8, startvalue+k);				// 4 elements dismissed
+		UT_TIME_END("_fff_write");
+	}
+	UT_ASSERT_CYCLES("_fff_write", FIFOFAST_TEST_CYCLES_WRITE);
+	UT_ASSERT(_fff_peek(fifo_uint8, 3)		== startvalue+3);
+	
+	_fff_reset(fifo_uint8);
 }
 
 void fifofast_test_macro_peek(uint8_t startvalue)
@@ -298,7 +357,9 @@ void fifofast_test_macro_rebase(uint8_t startvalue)
 	_fff_read_lite(fifo_uint8);
 	_fff_write_lite(fifo_uint8, startvalue+4);
 		
+	UT_TIME_BEGIN("_fff_rebase");
 	_fff_rebase(fifo_uint8);
+	UT_TIME_END("_fff_rebase");
 		
 	// Confirm it is exactly like before:
 	UT_ASSERT(_fff_mem_level(fifo_uint8)	== 4);
@@ -331,7 +392,9 @@ void fifofast_test_macro_rebase(uint8_t startvalue)
 	_fff_write_lite(fifo_uint8, startvalue+4);
 	_fff_write_lite(fifo_uint8, startvalue+5);
 	
+	UT_TIME_BEGIN("_fff_rebase");
 	_fff_rebase(fifo_uint8);
+	UT_TIME_END("_fff_rebase");
 	
 	// Confirm it is exactly like before:
 	UT_ASSERT(_fff_mem_level(fifo_uint8)	== 4);
@@ -366,7 +429,9 @@ void fifofast_test_macro_rebase(uint8_t startvalue)
 	_fff_write_lite(fifo_uint8, startvalue+5);
 	_fff_write_lite(fifo_uint8, startvalue+6);
 	
+	UT_TIME_BEGIN("_fff_rebase");
 	_fff_rebase(fifo_uint8);
+	UT_TIME_END("_fff_rebase");
 	
 	// Confirm it is exactly like before:
 	UT_ASSERT(_fff_mem_level(fifo_uint8)	== 4);
@@ -383,6 +448,40 @@ void fifofast_test_macro_rebase(uint8_t startvalue)
 	UT_ASSERT(&_fff_peek(fifo_uint8, 0)		== &fifo_uint8.data[0]);
 	
 	_fff_reset(fifo_uint8);
+	
+	
+	//////////////////////////////////////////////////////////////////////////
+	// Test 4: partially filled, wrapped fifo with larger elements
+	
+	// fifo_int16 has 8 slots: move read index to 6, then store 5 elements
+	_fff_write_commit(fifo_int16, 6);
+	_fff_remove_lite(fifo_int16, 6);
+	for (uint8_t k = 0; k < 5; k++)
+		_fff_write_lite(fifo_int16, -startvalue-k);
+	
+	int16_t linear[8];
+	UT_ASSERT(_fff_linearize(fifo_int16, linear)	== 5);
+	UT_ASSERT(_fff_mem_level(fifo_int16)			== 5);		// not removed
+	for (uint8_t k = 0; k < 5; k++)
+		UT_ASSERT(linear[k]						== -startvalue-k);
+	
+	UT_TIME_BEGIN("_fff_rebase");
+	_fff_rebase(fifo_int16);
+	UT_TIME_END("_fff_rebase");
+	
+	UT_ASSERT(_fff_mem_level(fifo_int16)	== 5);
+	UT_ASSERT(&_fff_peek(fifo_int16, 0)		== &fifo_int16.data[0]);
+	for (uint8_t k = 0; k < 5; k++)
+		UT_ASSERT(fifo_int16.data[k]		== -startvalue-k);
+	
+	// write index must follow the stored elements
+	_fff_write_lite(fifo_int16, startvalue);
+	UT_ASSERT(fifo_int16.data[5]			== startvalue);
+	
+	_fff_reset(fifo_int16);
+	
+	// performance budget of all rebases which move elements
+	UT_ASSERT_CYCLES("_fff_rebase", FIFOFAST_TEST_CYCLES_REBASE);
 }
 
 void fifofast_test_macro_write_multiple(uint8_t startvalue) {
@@ -395,7 +494,7 @@ void fifofast_test_macro_write_multiple(uint8_t startvalue) {
 	_fff_remove_lite(fifo_uint8, 2);
 
 	// write test data, case: all data fits
-	_fff_write_multiple(fifo_uint8, multidata, 3);
+	UT_ASSERT(_fff_write_multiple(fifo_uint8, multidata, 3)	== 3);
 
 	UT_ASSERT(_fff_peek(fifo_uint8, 0)		== startvalue+2);
 	UT_ASSERT(_fff_peek(fifo_uint8, 1)		== startvalue+3);
@@ -414,7 +513,7 @@ void fifofast_test_macro_write_multiple(uint8_t startvalue) {
 	_fff_write_multiple(fifo_uint8, multidata, 3);
 	
 	// write test data, case: NOT all data fits (overflow is discarded)
-	_fff_write_multiple(fifo_uint8, multidata, 4);
+	UT_ASSERT(_fff_write_multiple(fifo_uint8, multidata, 4)	== 0);
 	
 	UT_ASSERT(_fff_peek(fifo_uint8, 0)		== startvalue+7);
 	UT_ASSERT(_fff_peek(fifo_uint8, 1)		== startvalue+3);
@@ -425,8 +524,1158 @@ void fifofast_test_macro_write_multiple(uint8_t startvalue) {
 	UT_ASSERT(_fff_mem_free(fifo_uint8)		== 0);
 	UT_ASSERT(_fff_is_empty(fifo_uint8)		== 0);
 	UT_ASSERT(_fff_is_full(fifo_uint8)		== 1);
+	
+	_fff_reset(fifo_uint8);
+	
+	// multi-byte elements, case: data wraps around the end of the array
+	int16_t multidata16[6] = {-1000-startvalue, 1001, -1002, 1003, -1004, 1005};
+	_fff_write_lite(fifo_int16, 0);
+	_fff_write_lite(fifo_int16, 0);
+	_fff_write_lite(fifo_int16, 0);
+	_fff_write_lite(fifo_int16, 0);
+	_fff_write_lite(fifo_int16, 0);
+	_fff_remove_lite(fifo_int16, 5);
+	
+	UT_ASSERT(_fff_write_multiple(fifo_int16, multidata16, 6)	== 6);
+	UT_ASSERT(_fff_mem_level(fifo_int16)	== 6);
+	for (uint8_t idx = 0; idx < 6; idx++)
+		UT_ASSERT(_fff_peek(fifo_int16, idx) == multidata16[idx]);
+	
+	_fff_reset(fifo_int16);
+}
+
+void fifofast_test_macro_read_multiple(uint8_t startvalue)
+{
+	uint8_t multidata[5] = {0};
+	
+	// offset the indices, so the data wraps around the end of the array
+	_fff_write_lite(fifo_uint8, startvalue+0);
+	_fff_write_lite(fifo_uint8, startvalue+1);
+	_fff_write_lite(fifo_uint8, startvalue+2);
+	_fff_remove_lite(fifo_uint8, 3);
+	_fff_write_lite(fifo_uint8, startvalue+3);
+	_fff_write_lite(fifo_uint8, startvalue+4);
+	_fff_write_lite(fifo_uint8, startvalue+5);
+	
+	// case: less elements requested than stored
+	UT_ASSERT(_fff_read_multiple(fifo_uint8, multidata, 2)	== 2);
+	UT_ASSERT(multidata[0]					== startvalue+3);
+	UT_ASSERT(multidata[1]					== startvalue+4);
+	UT_ASSERT(_fff_mem_level(fifo_uint8)	== 1);
+	UT_ASSERT(_fff_peek(fifo_uint8, 0)		== startvalue+5);
+	
+	// case: more elements requested than stored
+	_fff_write_lite(fifo_uint8, startvalue+6);
+	_fff_write_lite(fifo_uint8, startvalue+7);
+	UT_ASSERT(_fff_read_multiple(fifo_uint8, multidata, 5)	== 3);
+	UT_ASSERT(multidata[0]					== startvalue+5);
+	UT_ASSERT(multidata[1]					== startvalue+6);
+	UT_ASSERT(multidata[2]					== startvalue+7);
+	UT_ASSERT(_fff_is_empty(fifo_uint8)		!= 0);
+	
+	// case: empty fifo
+	UT_ASSERT(_fff_read_multiple(fifo_uint8, multidata, 5)	== 0);
+	
+	// multi-byte elements, case: data wraps around the end of the array
+	int16_t multidata16[8] = {0};
+	for (uint8_t idx = 0; idx < 7; idx++)
+		_fff_write_lite(fifo_int16, idx);
+	_fff_remove_lite(fifo_int16, 6);
+	for (uint8_t idx = 0; idx < 5; idx++)
+		_fff_write_lite(fifo_int16, -1000*idx-startvalue);
+	
+	UT_ASSERT(_fff_read_multiple(fifo_int16, multidata16, 8)	== 6);
+	UT_ASSERT(multidata16[0] == 6);
+	for (uint8_t idx = 0; idx < 5; idx++)
+		UT_ASSERT(multidata16[idx+1] == -1000*idx-startvalue);
+	UT_ASSERT(_fff_is_empty(fifo_int16)		!= 0);
+	
+	_fff_reset(fifo_uint8);
+	_fff_reset(fifo_int16);
+}
+
+void fifofast_test_macro_span(uint8_t startvalue)
+{
+	fff_span_t span;
+	
+	// offset the indices, so the free space wraps around the end of the array
+	_fff_write_lite(fifo_uint8, startvalue+0);
+	_fff_write_lite(fifo_uint8, startvalue+1);
+	_fff_write_lite(fifo_uint8, startvalue+2);
+	_fff_remove_lite(fifo_uint8, 2);
+	
+	// reserve more than available: 3 free elements, 1 before and 2 after the wrap
+	span = _fff_write_reserve(fifo_uint8, 4);
+	UT_ASSERT(span.len[0]					== 1);
+	UT_ASSERT(span.len[1]					== 2);
+	UT_ASSERT(_fff_span_len(span)			== 3);
+	UT_ASSERT(_fff_span_ptr(fifo_uint8, span, 0)	== &fifo_uint8.data[3]);
+	UT_ASSERT(_fff_span_ptr(fifo_uint8, span, 1)	== &fifo_uint8.data[0]);
+	UT_ASSERT(_fff_mem_level(fifo_uint8)	== 1);		// nothing added yet
+	
+	_fff_span_ptr(fifo_uint8, span, 0)[0] = startvalue+3;
+	_fff_span_ptr(fifo_uint8, span, 1)[0] = startvalue+4;
+	_fff_write_commit(fifo_uint8, 2);
+	
+	UT_ASSERT(_fff_mem_level(fifo_uint8)	== 3);
+	UT_ASSERT(_fff_peek(fifo_uint8, 0)		== startvalue+2);
+	UT_ASSERT(_fff_peek(fifo_uint8, 1)		== startvalue+3);
+	UT_ASSERT(_fff_peek(fifo_uint8, 2)		== startvalue+4);
+	
+	// acquire all stored elements: 2 before and 1 after the wrap
+	span = _fff_read_acquire(fifo_uint8, 10);
+	UT_ASSERT(span.len[0]					== 2);
+	UT_ASSERT(span.len[1]					== 1);
+	UT_ASSERT(_fff_span_ptr(fifo_uint8, span, 0)[1]	== startvalue+3);
+	UT_ASSERT(_fff_span_ptr(fifo_uint8, span, 1)[0]	== startvalue+4);
+	_fff_read_release(fifo_uint8, 2);
+	
+	UT_ASSERT(_fff_mem_level(fifo_uint8)	== 1);
+	UT_ASSERT(_fff_peek(fifo_uint8, 0)		== startvalue+4);
+	
+	_fff_reset(fifo_uint8);
+	
+	// spsc variant, case: wrap of the data array
+	_fff_spsc_write_lite(fifo_uint8_spsc, startvalue+0);
+	_fff_spsc_write_lite(fifo_uint8_spsc, startvalue+1);
+	_fff_spsc_write_lite(fifo_uint8_spsc, startvalue+2);
+	_fff_spsc_remove(fifo_uint8_spsc, 3);
+	
+	span = _fff_spsc_write_reserve(fifo_uint8_spsc, 4);
+	UT_ASSERT(span.len[0]					== 1);
+	UT_ASSERT(span.len[1]					== 3);
+	for (uint8_t idx = 0; idx < 4; idx++)
+		_fff_span_ptr(fifo_uint8_spsc, span, idx ? 1 : 0)[idx ? idx-1 : 0] = startvalue+idx;
+	UT_ASSERT(_fff_spsc_is_empty(fifo_uint8_spsc)	!= 0);		// not published yet
+	_fff_spsc_write_commit(fifo_uint8_spsc, 4);
+	UT_ASSERT(_fff_spsc_is_full(fifo_uint8_spsc)	!= 0);
+	
+	span = _fff_spsc_read_acquire(fifo_uint8_spsc, 3);
+	UT_ASSERT(_fff_span_len(span)			== 3);
+	UT_ASSERT(_fff_span_ptr(fifo_uint8_spsc, span, 0)[0]	== startvalue+0);
+	UT_ASSERT(_fff_span_ptr(fifo_uint8_spsc, span, 1)[1]	== startvalue+2);
+	_fff_spsc_read_release(fifo_uint8_spsc, 3);
+	UT_ASSERT(_fff_spsc_mem_level(fifo_uint8_spsc)	== 1);
+	UT_ASSERT(_fff_spsc_read_lite(fifo_uint8_spsc)	== startvalue+3);
+	
+	// caches outside of the valid distance 0 ... depth are reloaded, spans never exceed depth
+	fifo_uint8_spsc.read_cache	= _FFF_SPSC_WRAP(fifo_uint8_spsc, fifo_uint8_spsc.write+1);
+	fifo_uint8_spsc.write_cache	= _FFF_SPSC_WRAP(fifo_uint8_spsc, fifo_uint8_spsc.read+5);
+	span = _fff_spsc_write_reserve(fifo_uint8_spsc, 8);
+	UT_ASSERT(_fff_span_len(span)			== 4);
+	span = _fff_spsc_read_acquire(fifo_uint8_spsc, 2);
+	UT_ASSERT(_fff_span_len(span)			== 0);
+	
+	_fff_spsc_reset(fifo_uint8_spsc);
+}
+
+void fifofast_test_macro_spsc(uint8_t startvalue)
+{
+	uint8_t tmp = 0;
+
+	UT_ASSERT(_fff_spsc_mem_level(fifo_uint8_spsc)	== 0);
+	UT_ASSERT(_fff_spsc_mem_free(fifo_uint8_spsc)	== 4);
+	UT_ASSERT(_fff_spsc_is_empty(fifo_uint8_spsc)	!= 0);
+	UT_ASSERT(_fff_spsc_read(fifo_uint8_spsc, &tmp)	== 0);		// empty, nothing to read
+	UT_ASSERT(tmp == 0);
+
+	// run through the free-running indices twice to cover the wrap at 2*depth
+	for (uint8_t round = 0; round < 3; round++)
+	{
+		_fff_spsc_write_lite(fifo_uint8_spsc, startvalue+0);
+		UT_ASSERT(_fff_spsc_write(fifo_uint8_spsc, startvalue+1)	!= 0);
+		UT_ASSERT(_fff_spsc_write(fifo_uint8_spsc, startvalue+2)	!= 0);
+		UT_ASSERT(_fff_spsc_write(fifo_uint8_spsc, startvalue+3)	!= 0);
+		UT_ASSERT(_fff_spsc_write(fifo_uint8_spsc, startvalue+4)	== 0);		// full, dismissed
+
+		UT_ASSERT(_fff_spsc_mem_level(fifo_uint8_spsc)	== 4);
+		UT_ASSERT(_fff_spsc_mem_free(fifo_uint8_spsc)	== 0);
+		UT_ASSERT(_fff_spsc_is_empty(fifo_uint8_spsc)	== 0);
+		UT_ASSERT(_fff_spsc_is_full(fifo_uint8_spsc)	!= 0);
+
+		UT_ASSERT(_fff_spsc_peek(fifo_uint8_spsc, 0)		== startvalue+0);
+		UT_ASSERT(_fff_spsc_peek(fifo_uint8_spsc, 3)		== startvalue+3);
+
+		UT_ASSERT(_fff_spsc_read_lite(fifo_uint8_spsc)		== startvalue+0);
+		UT_ASSERT(_fff_spsc_read(fifo_uint8_spsc, &tmp)		!= 0);
+		UT_ASSERT(tmp == startvalue+1);
+
+		_fff_spsc_remove(fifo_uint8_spsc, 1);
+		UT_ASSERT(_fff_spsc_mem_level(fifo_uint8_spsc)	== 1);
+		UT_ASSERT(_fff_spsc_peek(fifo_uint8_spsc, 0)		== startvalue+3);
+
+		// remove more than available
+		_fff_spsc_remove(fifo_uint8_spsc, 5);
+		UT_ASSERT(_fff_spsc_mem_level(fifo_uint8_spsc)	== 0);
+		UT_ASSERT(_fff_spsc_is_empty(fifo_uint8_spsc)	!= 0);
+		UT_ASSERT(_fff_spsc_is_full(fifo_uint8_spsc)	== 0);
+
+		// offset the indices for the next round
+		_fff_spsc_write_lite(fifo_uint8_spsc, startvalue+5);
+		UT_ASSERT(_fff_spsc_read_lite(fifo_uint8_spsc)		== startvalue+5);
+	}
+
+	_fff_spsc_reset(fifo_uint8_spsc);
+	UT_ASSERT(_fff_spsc_is_empty(fifo_uint8_spsc)	!= 0);
+}
+
+void fifofast_test_macro_spsc_mixed(uint8_t startvalue)
+{
+	uint8_t tmp = 0;
+	
+	// consumer: read_lite moves 'read' beyond the cached write index of the last _fff_spsc_read()
+	_fff_spsc_write_lite(fifo_uint8_spsc, startvalue+0);
+	UT_ASSERT(_fff_spsc_read(fifo_uint8_spsc, &tmp)		!= 0);
+	UT_ASSERT(tmp == startvalue+0);
+	_fff_spsc_write_lite(fifo_uint8_spsc, startvalue+1);
+	_fff_spsc_write_lite(fifo_uint8_spsc, startvalue+2);
+	_fff_spsc_write_lite(fifo_uint8_spsc, startvalue+3);
+	UT_ASSERT(_fff_spsc_read_lite(fifo_uint8_spsc)		== startvalue+1);
+	UT_ASSERT(_fff_spsc_read_lite(fifo_uint8_spsc)		== startvalue+2);
+	UT_ASSERT(_fff_spsc_read_lite(fifo_uint8_spsc)		== startvalue+3);
+	UT_ASSERT(_fff_spsc_read(fifo_uint8_spsc, &tmp)		== 0);		// empty
+	UT_ASSERT(_fff_spsc_mem_level(fifo_uint8_spsc)	== 0);
+	
+	// producer: write_lite fills the fifo a whole lap after the cached read index
+	_fff_spsc_reset(fifo_uint8_spsc);
+	for (uint8_t idx = 0; idx < 4; idx++)
+		_fff_spsc_write_lite(fifo_uint8_spsc, startvalue+idx);
+	_fff_spsc_remove(fifo_uint8_spsc, 4);
+	for (uint8_t idx = 0; idx < 4; idx++)
+		_fff_spsc_write_lite(fifo_uint8_spsc, startvalue+idx);
+	UT_ASSERT(_fff_spsc_write(fifo_uint8_spsc, startvalue+4)	== 0);		// full, dismissed
+	UT_ASSERT(_fff_spsc_mem_level(fifo_uint8_spsc)	== 4);
+	
+	// remove and release move 'read' beyond the cached write index as well
+	_fff_spsc_remove(fifo_uint8_spsc, 1);
+	UT_ASSERT(_fff_spsc_read(fifo_uint8_spsc, &tmp)		!= 0);
+	UT_ASSERT(tmp == startvalue+1);
+	_fff_spsc_write_lite(fifo_uint8_spsc, startvalue+5);
+	_fff_spsc_remove(fifo_uint8_spsc, 2);
+	fff_span_t span = _fff_spsc_read_acquire(fifo_uint8_spsc, 4);
+	UT_ASSERT(_fff_span_len(span)			== 1);
+	UT_ASSERT(_fff_span_ptr(fifo_uint8_spsc, span, 0)[0]	== startvalue+5);
+	_fff_spsc_read_release(fifo_uint8_spsc, 1);
+	UT_ASSERT(_fff_spsc_read(fifo_uint8_spsc, &tmp)		== 0);		// empty
+	span = _fff_spsc_read_acquire(fifo_uint8_spsc, 4);
+	UT_ASSERT(_fff_span_len(span)			== 0);
+	
+	// the producer still sees the whole space, but not more
+	span = _fff_spsc_write_reserve(fifo_uint8_spsc, 8);
+	UT_ASSERT(_fff_span_len(span)			== 4);
+	_fff_spsc_write_commit(fifo_uint8_spsc, 4);
+	UT_ASSERT(_fff_spsc_write(fifo_uint8_spsc, startvalue+6)	== 0);		// full, dismissed
+	span = _fff_spsc_write_reserve(fifo_uint8_spsc, 8);
+	UT_ASSERT(_fff_span_len(span)			== 0);
+	UT_ASSERT(_fff_spsc_mem_level(fifo_uint8_spsc)	== 4);
+	
+	// batched access after regular access
+	_fff_spsc_remove(fifo_uint8_spsc, 4);
+	for (uint8_t idx = 0; idx < 4; idx++)
+		_fff_spsc_write_lite(fifo_uint8_spsc, startvalue+idx);
+	UT_ASSERT(_fff_spsc_write_batch(fifo_uint8_spsc, startvalue+4)	== 0);	// full, dismissed
+	for (uint8_t idx = 0; idx < 4; idx++)
+		UT_ASSERT(_fff_spsc_read_lite(fifo_uint8_spsc)	== startvalue+idx);
+	UT_ASSERT(_fff_spsc_read_batch(fifo_uint8_spsc, &tmp)	== 0);		// empty
+	_fff_spsc_read_flush(fifo_uint8_spsc);
+	UT_ASSERT(_fff_spsc_mem_level(fifo_uint8_spsc)	== 0);
+	
+	_fff_spsc_reset(fifo_uint8_spsc);
+}
+
+void fifofast_test_macro_spsc_batch(uint8_t startvalue)
+{
+	uint8_t tmp = 0;
+	
+	// repeat with offset indices, so the batches wrap around the end of the array
+	for (uint8_t round = 0; round < 3; round++)
+	{
+		// pending elements are invisible until flushed
+		UT_ASSERT(_fff_spsc_write_batch(fifo_uint8_spsc, startvalue+0)	!= 0);
+		UT_ASSERT(_fff_spsc_write_batch(fifo_uint8_spsc, startvalue+1)	!= 0);
+		UT_ASSERT(_fff_spsc_mem_level(fifo_uint8_spsc)	== 0);
+		UT_ASSERT(_fff_spsc_read_batch(fifo_uint8_spsc, &tmp)	== 0);
+		_fff_spsc_flush(fifo_uint8_spsc);
+		UT_ASSERT(_fff_spsc_mem_level(fifo_uint8_spsc)	== 2);
+		
+		// a full fifo publishes the pending elements itself
+		UT_ASSERT(_fff_spsc_write_batch(fifo_uint8_spsc, startvalue+2)	!= 0);
+		UT_ASSERT(_fff_spsc_write_batch(fifo_uint8_spsc, startvalue+3)	!= 0);
+		UT_ASSERT(_fff_spsc_write_batch(fifo_uint8_spsc, startvalue+4)	== 0);	// dismissed
+		UT_ASSERT(_fff_spsc_is_full(fifo_uint8_spsc)	!= 0);
+		
+		// consumer reads from its snapshot; the space is handed back when it is drained
+		UT_ASSERT(_fff_spsc_read_batch(fifo_uint8_spsc, &tmp)	!= 0);
+		UT_ASSERT(tmp == startvalue+0);
+		UT_ASSERT(_fff_spsc_read_batch(fifo_uint8_spsc, &tmp)	!= 0);
+		UT_ASSERT(tmp == startvalue+1);
+		UT_ASSERT(_fff_spsc_is_full(fifo_uint8_spsc)	!= 0);		// not released yet
+		_fff_spsc_read_flush(fifo_uint8_spsc);
+		UT_ASSERT(_fff_spsc_mem_level(fifo_uint8_spsc)	== 2);
+		
+		// regular macros can be mixed in after a flush
+		UT_ASSERT(_fff_spsc_read_lite(fifo_uint8_spsc)		== startvalue+2);
+		UT_ASSERT(_fff_spsc_read_batch(fifo_uint8_spsc, &tmp)	!= 0);
+		UT_ASSERT(tmp == startvalue+3);
+		UT_ASSERT(_fff_spsc_read_batch(fifo_uint8_spsc, &tmp)	== 0);
+		UT_ASSERT(_fff_spsc_is_empty(fifo_uint8_spsc)	!= 0);		// drained snapshot was released
+		
+		_fff_spsc_write_lite(fifo_uint8_spsc, startvalue+5);
+		UT_ASSERT(_fff_spsc_read_batch(fifo_uint8_spsc, &tmp)	!= 0);
+		UT_ASSERT(tmp == startvalue+5);
+		_fff_spsc_read_flush(fifo_uint8_spsc);
+	}
+	
+	// a cache which can't be valid is reloaded instead of read
+	fifo_uint8_spsc.write_cache	= _FFF_SPSC_WRAP(fifo_uint8_spsc, fifo_uint8_spsc.read_local+5);
+	UT_ASSERT(_fff_spsc_read_batch(fifo_uint8_spsc, &tmp)	== 0);
+	fifo_uint8_spsc.read_cache	= _FFF_SPSC_WRAP(fifo_uint8_spsc, fifo_uint8_spsc.write_local+1);
+	for (uint8_t idx = 0; idx < 4; idx++)
+		UT_ASSERT(_fff_spsc_write_batch(fifo_uint8_spsc, startvalue+idx)	!= 0);
+	UT_ASSERT(_fff_spsc_write_batch(fifo_uint8_spsc, startvalue+4)	== 0);	// full, dismissed
+	UT_ASSERT(_fff_spsc_mem_level(fifo_uint8_spsc)	== 4);
+	
+	_fff_spsc_reset(fifo_uint8_spsc);
+	UT_ASSERT(_fff_spsc_is_empty(fifo_uint8_spsc)	!= 0);
+}
+
+void fifofast_test_macro_mpmc(uint8_t startvalue)
+{
+	uint8_t tmp = 0;
+
+	UT_ASSERT(_fff_mpmc_mem_level(fifo_uint8_mpmc)	== 0);
+	UT_ASSERT(_fff_mpmc_mem_free(fifo_uint8_mpmc)	== 4);
+	UT_ASSERT(_fff_mpmc_is_empty(fifo_uint8_mpmc)	!= 0);
+	UT_ASSERT(_fff_mpmc_read(fifo_uint8_mpmc, &tmp)	== 0);		// empty, nothing to read
+	UT_ASSERT(tmp == 0);
+
+	// several rounds to cover the lap counter in 'seq[]'
+	for (uint8_t round = 0; round < 3; round++)
+	{
+		UT_ASSERT(_fff_mpmc_write(fifo_uint8_mpmc, startvalue+0)	!= 0);
+		UT_ASSERT(_fff_mpmc_write(fifo_uint8_mpmc, startvalue+1)	!= 0);
+		UT_ASSERT(_fff_mpmc_write(fifo_uint8_mpmc, startvalue+2)	!= 0);
+		UT_ASSERT(_fff_mpmc_write(fifo_uint8_mpmc, startvalue+3)	!= 0);
+		UT_ASSERT(_fff_mpmc_write(fifo_uint8_mpmc, startvalue+4)	== 0);		// full, dismissed
+
+		UT_ASSERT(_fff_mpmc_mem_level(fifo_uint8_mpmc)	== 4);
+		UT_ASSERT(_fff_mpmc_mem_free(fifo_uint8_mpmc)	== 0);
+		UT_ASSERT(_fff_mpmc_is_full(fifo_uint8_mpmc)	!= 0);
+
+		UT_ASSERT(_fff_mpmc_read(fifo_uint8_mpmc, &tmp)	!= 0);
+		UT_ASSERT(tmp == startvalue+0);
+		UT_ASSERT(_fff_mpmc_read(fifo_uint8_mpmc, &tmp)	!= 0);
+		UT_ASSERT(tmp == startvalue+1);
+
+		// free slot can be re-used while other elements are still stored
+		UT_ASSERT(_fff_mpmc_write(fifo_uint8_mpmc, startvalue+5)	!= 0);
+		UT_ASSERT(_fff_mpmc_mem_level(fifo_uint8_mpmc)	== 3);
+
+		UT_ASSERT(_fff_mpmc_read(fifo_uint8_mpmc, &tmp)	!= 0);
+		UT_ASSERT(tmp == startvalue+2);
+		UT_ASSERT(_fff_mpmc_read(fifo_uint8_mpmc, &tmp)	!= 0);
+		UT_ASSERT(tmp == startvalue+3);
+		UT_ASSERT(_fff_mpmc_read(fifo_uint8_mpmc, &tmp)	!= 0);
+		UT_ASSERT(tmp == startvalue+5);
+		UT_ASSERT(_fff_mpmc_read(fifo_uint8_mpmc, &tmp)	== 0);		// empty again
+		UT_ASSERT(tmp == startvalue+5);
+
+		UT_ASSERT(_fff_mpmc_is_empty(fifo_uint8_mpmc)	!= 0);
+	}
+
+	_fff_mpmc_reset(fifo_uint8_mpmc);
+	UT_ASSERT(_fff_mpmc_is_empty(fifo_uint8_mpmc)	!= 0);
+}
+
+void fifofast_test_macro_mpsc(uint8_t startvalue)
+{
+	uint8_t tmp = 0;
+
+	UT_ASSERT(_fff_mpsc_mem_level(fifo_uint8_mpsc)	== 0);
+	UT_ASSERT(_fff_mpsc_mem_free(fifo_uint8_mpsc)	== 4);
+	UT_ASSERT(_fff_mpsc_is_empty(fifo_uint8_mpsc)	!= 0);
+	UT_ASSERT(_fff_mpsc_read(fifo_uint8_mpsc, &tmp)	== 0);		// empty, nothing to read
+	UT_ASSERT(tmp == 0);
+
+	for (uint8_t round = 0; round < 3; round++)
+	{
+		UT_ASSERT(_fff_mpsc_write(fifo_uint8_mpsc, startvalue+0)	!= 0);
+		UT_ASSERT(_fff_mpsc_write(fifo_uint8_mpsc, startvalue+1)	!= 0);
+		UT_ASSERT(_fff_mpsc_write(fifo_uint8_mpsc, startvalue+2)	!= 0);
+		UT_ASSERT(_fff_mpsc_write(fifo_uint8_mpsc, startvalue+3)	!= 0);
+		UT_ASSERT(_fff_mpsc_write(fifo_uint8_mpsc, startvalue+4)	== 0);		// full, dismissed
+
+		UT_ASSERT(_fff_mpsc_mem_level(fifo_uint8_mpsc)	== 4);
+		UT_ASSERT(_fff_mpsc_mem_free(fifo_uint8_mpsc)	== 0);
+		UT_ASSERT(_fff_mpsc_is_empty(fifo_uint8_mpsc)	== 0);
+		UT_ASSERT(_fff_mpsc_is_full(fifo_uint8_mpsc)	!= 0);
+
+		UT_ASSERT(_fff_mpsc_read_lite(fifo_uint8_mpsc)	== startvalue+0);
+		UT_ASSERT(_fff_mpsc_read(fifo_uint8_mpsc, &tmp)	!= 0);
+		UT_ASSERT(tmp == startvalue+1);
+
+		UT_ASSERT(_fff_mpsc_write(fifo_uint8_mpsc, startvalue+5)	!= 0);
+		UT_ASSERT(_fff_mpsc_mem_level(fifo_uint8_mpsc)	== 3);
+
+		UT_ASSERT(_fff_mpsc_read_lite(fifo_uint8_mpsc)	== startvalue+2);
+		UT_ASSERT(_fff_mpsc_read_lite(fifo_uint8_mpsc)	== startvalue+3);
+		UT_ASSERT(_fff_mpsc_read_lite(fifo_uint8_mpsc)	== startvalue+5);
+		UT_ASSERT(_fff_mpsc_read(fifo_uint8_mpsc, &tmp)	== 0);		// empty again
+		UT_ASSERT(tmp == startvalue+1);
+
+		UT_ASSERT(_fff_mpsc_mem_level(fifo_uint8_mpsc)	== 0);
+		UT_ASSERT(_fff_mpsc_is_empty(fifo_uint8_mpsc)	!= 0);
+	}
+
+	_fff_mpsc_reset(fifo_uint8_mpsc);
+	UT_ASSERT(_fff_mpsc_is_empty(fifo_uint8_mpsc)	!= 0);
+}
+
+void fifofast_test_macro_exact(uint8_t startvalue)
+{
+	uint8_t multidata[5] = {startvalue+0, startvalue+1, startvalue+2, startvalue+3, startvalue+4};
+	uint8_t result[5] = {0};
+	
+	UT_ASSERT(_fff_mem_depth(fifo_exact)	== 5);		// constant
+	UT_ASSERT(sizeof(fifo_exact.data)		== 5);
+	
+	// write and read past the end of the array several times
+	for (uint8_t k = 0; k < 12; k++)
+	{
+		_fff_write(fifo_exact, startvalue+k);
+		_fff_write(fifo_exact, startvalue+k+1);
+		UT_ASSERT(_fff_peek(fifo_exact, 1)		== startvalue+k+1);
+		UT_ASSERT(_fff_read_lite(fifo_exact)	== startvalue+k);
+		UT_ASSERT(_fff_read_lite(fifo_exact)	== startvalue+k+1);
+		UT_ASSERT(fifo_exact.read				< 5);
+	}
+	UT_ASSERT(_fff_is_empty(fifo_exact)		!= 0);
+	
+	// fill completely; a 6th element is dismissed
+	UT_ASSERT(_fff_write_multiple(fifo_exact, multidata, 5)	== 5);
+	_fff_write(fifo_exact, startvalue+5);
+	UT_ASSERT(_fff_is_full(fifo_exact)		!= 0);
+	UT_ASSERT(_fff_mem_free(fifo_exact)		== 0);
+	UT_ASSERT(_fff_peek(fifo_exact, 4)		== startvalue+4);
+	UT_ASSERT(_fff_peek(fifo_exact, 5)		== startvalue+0);		// wraps like an array of 5
+	
+	_fff_remove(fifo_exact, 2);
+	UT_ASSERT(_fff_write_multiple(fifo_exact, multidata, 2)	== 2);
+	_fff_rebase(fifo_exact);
+	UT_ASSERT(&_fff_peek(fifo_exact, 0)		== &fifo_exact.data[0]);
+	UT_ASSERT(fifo_exact.data[2]			== startvalue+4);
+	UT_ASSERT(fifo_exact.data[3]			== startvalue+0);
+	
+	UT_ASSERT(_fff_read_multiple(fifo_exact, result, 5)		== 5);
+	UT_ASSERT(result[0]						== startvalue+2);
+	UT_ASSERT(result[4]						== startvalue+1);
+	UT_ASSERT(_fff_is_empty(fifo_exact)		!= 0);
+	
+	_fff_reset(fifo_exact);
+}
+
+void fifofast_test_macro_options(uint8_t startvalue)
+{
+	uint8_t multidata[6] = {startvalue+0, startvalue+1, startvalue+2, startvalue+3, startvalue+4, startvalue+5};
+	uint8_t result[4] = {0};
+	
+	// options are constant and use no RAM
+	UT_ASSERT(_fff_options(fifo_uint8)		== FFF_OPT_NONE);
+	UT_ASSERT(_fff_options(fifo_ring)		== (FFF_OPT_OVERWRITE | FFF_OPT_COUNT_DROPS));
+	UT_ASSERT(sizeof(fifo_exact)			== 3+5);
+	UT_ASSERT(sizeof(fifo_uint8.drops)		== 0);
+	UT_ASSERT(sizeof(fifo_ring.drops)		== sizeof(uint32_t));
+	
+	// without FFF_OPT_OVERWRITE the new element is dismissed and nothing is counted
+	for (uint8_t k = 0; k < 5; k++)
+		_fff_write(fifo_uint8, startvalue+k);
+	UT_ASSERT(_fff_peek(fifo_uint8, 0)		== startvalue+0);
+	UT_ASSERT(_fff_drops(fifo_uint8)		== 0);
+	_fff_reset(fifo_uint8);
+	
+	// newest elements replace the oldest
+	for (uint8_t k = 0; k < 6; k++)
+		_fff_write(fifo_ring, startvalue+k);
+	UT_ASSERT(_fff_mem_level(fifo_ring)		== 4);
+	UT_ASSERT(_fff_is_full(fifo_ring)		!= 0);
+	UT_ASSERT(_fff_drops(fifo_ring)			== 2);
+	UT_ASSERT(_fff_peek(fifo_ring, 0)		== startvalue+2);
+	UT_ASSERT(_fff_peek(fifo_ring, 3)		== startvalue+5);
+	
+	// _fff_add evicts as well and never returns NULL
+	uint8_t* ptr = _fff_add(fifo_ring);
+	UT_ASSERT(ptr							!= NULL);
+	*ptr = startvalue+6;
+	UT_ASSERT(_fff_drops(fifo_ring)			== 3);
+	UT_ASSERT(_fff_read_lite(fifo_ring)		== startvalue+3);
+	
+	// 6 elements into 1 free slot: 2 elements are skipped, 3 stored elements are evicted
+	UT_ASSERT(_fff_write_multiple(fifo_ring, multidata, 6)	== 4);
+	UT_ASSERT(_fff_drops(fifo_ring)			== 3+5);
+	UT_ASSERT(_fff_read_multiple(fifo_ring, result, 4)		== 4);
+	UT_ASSERT(result[0]						== startvalue+2);
+	UT_ASSERT(result[3]						== startvalue+5);
+	UT_ASSERT(_fff_is_empty(fifo_ring)		!= 0);
+	
+	// partial overflow evicts only as many elements as needed
+	_fff_write(fifo_ring, startvalue+0);
+	_fff_write(fifo_ring, startvalue+1);
+	UT_ASSERT(_fff_write_multiple(fifo_ring, multidata+2, 3)	== 3);
+	UT_ASSERT(_fff_drops(fifo_ring)			== 3+5+1);
+	UT_ASSERT(_fff_peek(fifo_ring, 0)		== startvalue+1);
+	UT_ASSERT(_fff_peek(fifo_ring, 3)		== startvalue+4);
+	
+	_fff_reset(fifo_ring);
+}
+
+void fifofast_test_macro_record(uint8_t startvalue)
+{
+	uint8_t msg[15];
+	uint8_t result[15];
+	for (uint8_t k = 0; k < 15; k++)
+		msg[k] = startvalue+k;
+	
+	UT_ASSERT(_FFF_RECORD_PREFIX(fifo_record)	== 1);
+	UT_ASSERT(_fff_record_len(fifo_record)		== 0);
+	UT_ASSERT(_fff_record_peek(fifo_record)		== NULL);
+	UT_ASSERT(_fff_record_read(fifo_record, result, 15)	== 0);
+	
+	// records of 0 or more than 15 bytes can't be stored
+	UT_ASSERT(_fff_record_write(fifo_record, msg, 0)	== 0);
+	UT_ASSERT(_fff_record_write(fifo_record, msg, 16)	== 0);
+	
+	// 3 records of 3+1, 5+1 and 4+1 bytes
+	UT_ASSERT(_fff_record_write(fifo_record, msg, 3)	!= 0);
+	UT_ASSERT(_fff_record_write(fifo_record, msg+3, 5)	!= 0);
+	UT_ASSERT(_fff_record_write(fifo_record, msg+8, 4)	!= 0);
+	UT_ASSERT(_fff_mem_level(fifo_record)		== 15);
+	UT_ASSERT(_fff_record_write(fifo_record, msg, 1)	== 0);		// 1+1 bytes don't fit
+	
+	// zero-copy access
+	UT_ASSERT(_fff_record_len(fifo_record)		== 3);
+	UT_ASSERT(_fff_record_peek(fifo_record)[2]	== startvalue+2);
+	_fff_record_remove(fifo_record);
+	UT_ASSERT(_fff_record_read(fifo_record, result, 15)	== 5);
+	UT_ASSERT(result[4]							== startvalue+7);
+	
+	// 6+1 bytes would wrap at index 15: 1 byte is skipped, the record is stored at index 0
+	UT_ASSERT(_fff_record_write(fifo_record, msg, 6)	!= 0);
+	UT_ASSERT(_fff_mem_level(fifo_record)		== 5+1+7);
+	UT_ASSERT(_fff_record_read(fifo_record, result, 2)	== 4);		// only 2 bytes copied
+	UT_ASSERT(result[0]							== startvalue+8);
+	UT_ASSERT(result[2]							== startvalue+5);		// not modified
+	UT_ASSERT(_fff_record_len(fifo_record)		== 6);
+	UT_ASSERT(_fff_record_peek(fifo_record)		== &fifo_record.data[1]);
+	UT_ASSERT(_fff_record_peek(fifo_record)[5]	== startvalue+5);
+	_fff_record_remove(fifo_record);
+	UT_ASSERT(_fff_is_empty(fifo_record)		!= 0);
+	
+	// the largest record fits into an empty fifo, regardless of the previous indices
+	UT_ASSERT(_fff_record_write(fifo_record, msg, 15)	!= 0);
+	UT_ASSERT(_fff_record_read(fifo_record, result, 15)	== 15);
+	UT_ASSERT(result[14]						== startvalue+14);
+	
+	_fff_reset(fifo_record);
+}
+
+void fifofast_test_macro_bip(uint8_t startvalue)
+{
+	fff_span_t span;
+	
+	UT_ASSERT(_fff_mem_depth(fifo_bip)			== 10);		// not rounded up
+	span = _fff_bip_read_acquire(fifo_bip);
+	UT_ASSERT(span.len[0]						== 0);
+	
+	// fill 7 elements, read 5
+	span = _fff_bip_write_reserve(fifo_bip, 7);
+	UT_ASSERT(span.len[0]						== 7);
+	UT_ASSERT(span.len[1]						== 0);
+	for (uint8_t k = 0; k < 7; k++)
+		((uint8_t*)span.ptr[0])[k] = startvalue+k;
+	_fff_bip_write_commit(fifo_bip, 7);
+	_fff_bip_read_release(fifo_bip, 5);
+	UT_ASSERT(_fff_bip_mem_level(fifo_bip)		== 2);
+	
+	// 4 elements don't fit behind A (3 free), so the larger block in front of A (5 free) is used
+	span = _fff_bip_write_reserve(fifo_bip, 4);
+	UT_ASSERT(span.ptr[0]						== &fifo_bip.data[0]);
+	UT_ASSERT(span.len[0]						== 4);
+	for (uint8_t k = 0; k < 4; k++)
+		((uint8_t*)span.ptr[0])[k] = startvalue+7+k;
+	_fff_bip_write_commit(fifo_bip, 3);						// only 3 used
+	UT_ASSERT(_fff_bip_mem_level(fifo_bip)		== 5);
+	
+	// B continues until it reaches A
+	span = _fff_bip_write_reserve(fifo_bip, 8);
+	UT_ASSERT(span.ptr[0]						== &fifo_bip.data[3]);
+	UT_ASSERT(span.len[0]						== 2);
+	
+	// reader gets A first, then B; each block is contiguous
+	span = _fff_bip_read_acquire(fifo_bip);
+	UT_ASSERT(span.ptr[0]						== &fifo_bip.data[5]);
+	UT_ASSERT(span.len[0]						== 2);
+	UT_ASSERT(((uint8_t*)span.ptr[0])[1]		== startvalue+6);
+	_fff_bip_read_release(fifo_bip, 2);
+	
+	span = _fff_bip_read_acquire(fifo_bip);
+	UT_ASSERT(span.ptr[0]						== &fifo_bip.data[0]);
+	UT_ASSERT(span.len[0]						== 3);
+	UT_ASSERT(((uint8_t*)span.ptr[0])[0]		== startvalue+7);
+	
+	// the pending reservation continues the former B, now A
+	fifo_bip.data[3] = startvalue+10;
+	_fff_bip_write_commit(fifo_bip, 1);
+	UT_ASSERT(_fff_bip_mem_level(fifo_bip)		== 4);
+	span = _fff_bip_read_acquire(fifo_bip);
+	UT_ASSERT(span.len[0]						== 4);
+	UT_ASSERT(((uint8_t*)span.ptr[0])[3]		== startvalue+10);
+	_fff_bip_read_release(fifo_bip, 10);					// more than available
+	UT_ASSERT(_fff_bip_is_empty(fifo_bip)		!= 0);
+	
+	// an empty buffer restarts at index 0
+	span = _fff_bip_write_reserve(fifo_bip, 10);
+	UT_ASSERT(span.ptr[0]						== &fifo_bip.data[0]);
+	UT_ASSERT(span.len[0]						== 10);
+	
+	_fff_bip_reset(fifo_bip);
+}
+
+void fifofast_test_macro_pq(uint8_t startvalue)
+{
+	uint8_t result = 0;
+	
+	UT_ASSERT(_fff_pq_levels(fifo_pq)			== 40);
+	UT_ASSERT(_fff_pq_is_empty(fifo_pq)			!= 0);
+	UT_ASSERT(_fff_pq_read_highest(fifo_pq, &result)	== -1);
+	UT_ASSERT(result							== 0);		// unchanged
+	
+	// lowest level is read first, independent of the order of writes
+	_fff_pq_write(fifo_pq, 37, startvalue);
+	_fff_pq_write(fifo_pq, 3, startvalue+1);
+	_fff_pq_write(fifo_pq, 3, startvalue+2);
+	UT_ASSERT(_fff_pq_highest(fifo_pq)			== 3);
+	UT_ASSERT(_fff_pq_read_highest(fifo_pq, &result)	== 3);
+	UT_ASSERT(result							== startvalue+1);
+	UT_ASSERT(_fff_pq_read_highest(fifo_pq, &result)	== 3);
+	UT_ASSERT(result							== startvalue+2);
+	UT_ASSERT(_fff_pq_read_highest(fifo_pq, &result)	== 37);
+	UT_ASSERT(result							== startvalue);
+	UT_ASSERT(_fff_pq_is_empty(fifo_pq)			!= 0);
+	
+	// direct access to a level requires an update of the bitmap
+	_fff_write(fifo_pq.q[7], startvalue+3);
+	UT_ASSERT(_fff_pq_highest(fifo_pq)			== -1);
+	_fff_pq_update(fifo_pq, 7);
+	UT_ASSERT(_fff_pq_highest(fifo_pq)			== 7);
+	_fff_pq_reset(fifo_pq);
+	UT_ASSERT(_fff_pq_is_empty(fifo_pq)			!= 0);
+	
+	// weighted round-robin: level 0 gets 2 elements per turn, all others 1
+	fifo_pq.weight[0] = 2;
+	_fff_pq_write(fifo_pq, 0, startvalue);
+	_fff_pq_write(fifo_pq, 0, startvalue+1);
+	_fff_pq_write(fifo_pq, 0, startvalue+2);
+	_fff_pq_write(fifo_pq, 5, startvalue+10);
+	_fff_pq_write(fifo_pq, 5, startvalue+11);
+	_fff_pq_write(fifo_pq, 39, startvalue+20);
+	
+	const int8_t levels[] = {0, 0, 5, 39, 0, 5, -1};
+	const uint8_t values[] = {startvalue, startvalue+1, startvalue+10, startvalue+20, startvalue+2, startvalue+11};
+	for (uint8_t k = 0; k < _sizeof_array(levels); k++)
+	{
+		UT_ASSERT(_fff_pq_read_wrr(fifo_pq, &result)	== levels[k]);
+		if (levels[k] >= 0)
+			UT_ASSERT(result						== values[k]);
+	}
+	
+	fifo_pq.weight[0] = 1;
+	_fff_pq_reset(fifo_pq);
+}
+
+void fifofast_test_macro_soa(uint8_t startvalue)
+{
+	// all levels are packed into a single array of 1 byte each
+	UT_ASSERT(sizeof(fifo_soa.level)			== 20);
+	UT_ASSERT(offsetof(struct fff_fifo_soa_s, level) - offsetof(struct fff_fifo_soa_s, read)	== 2*20);
+	UT_ASSERT(_fff_soa_size(fifo_soa)			== 20);
+	UT_ASSERT(_fff_soa_mem_depth(fifo_soa)		== 4);
+	UT_ASSERT(_fff_soa_count_nonempty(fifo_soa)	== 0);
+	UT_ASSERT(_fff_soa_read(fifo_soa, 3)		== 0);
+	
+	// fifos are independent of each other
+	for (uint8_t k = 0; k < 6; k++)
+		_fff_soa_write(fifo_soa, 3, startvalue+k);			// 2 elements dismissed
+	_fff_soa_write(fifo_soa, 17, startvalue+10);
+	UT_ASSERT(_fff_soa_is_full(fifo_soa, 3)		!= 0);
+	UT_ASSERT(_fff_soa_mem_level(fifo_soa, 17)	== 1);
+	UT_ASSERT(_fff_soa_mem_free(fifo_soa, 17)	== 3);
+	UT_ASSERT(_fff_soa_count_nonempty(fifo_soa)	== 2);
+	UT_ASSERT(_fff_soa_find_nonempty(fifo_soa, 0)	== 3);
+	UT_ASSERT(_fff_soa_find_nonempty(fifo_soa, 4)	== 17);
+	UT_ASSERT(_fff_soa_find_nonempty(fifo_soa, 18)	== 20);
+	
+	// wrap around the end of the data array
+	UT_ASSERT(_fff_soa_read(fifo_soa, 3)		== startvalue);
+	UT_ASSERT(_fff_soa_read_lite(fifo_soa, 3)	== startvalue+1);
+	_fff_soa_write_lite(fifo_soa, 3, startvalue+6);
+	UT_ASSERT(_fff_soa_peek(fifo_soa, 3, 0)		== startvalue+2);
+	UT_ASSERT(_fff_soa_peek(fifo_soa, 3, 2)		== startvalue+6);
+	UT_ASSERT(fifo_soa.data[3][0]				== startvalue+6);
+	_fff_soa_remove(fifo_soa, 3, 10);						// more than available
+	UT_ASSERT(_fff_soa_is_empty(fifo_soa, 3)	!= 0);
+	
+	_fff_soa_reset(fifo_soa, 17);
+	UT_ASSERT(_fff_soa_count_nonempty(fifo_soa)	== 0);
+	
+	_fff_soa_write(fifo_soa, 0, startvalue);
+	_fff_soa_write(fifo_soa, 19, startvalue);
+	_fff_soa_reset_all(fifo_soa);
+	UT_ASSERT(_fff_soa_count_nonempty(fifo_soa)	== 0);
+	UT_ASSERT(fifo_soa.write[19]				== 0);
+}
+
+void fifofast_test_macro_stats(uint8_t startvalue)
+{
+	uint8_t multidata[6] = {startvalue+0, startvalue+1, startvalue+2, startvalue+3, startvalue+4, startvalue+5};
+	uint8_t result[4] = {0};
+	fff_stats_t stats;
+	
+	// counters are stored behind the data, the header is unchanged
+	UT_ASSERT(sizeof(fifo_uint8.stats)		== 0);
+	UT_ASSERT(sizeof(fifo_stats.stats)		== sizeof(fff_stats_t));
+	UT_ASSERT(offsetof(struct fff_fifo_stats_s, data)	== 3);
+	stats = _fff_stats(fifo_stats);
+	UT_ASSERT(stats.written					== 0);
+	UT_ASSERT(stats.high_water				== 0);
+	
+	// fill, overflow once and drain completely
+	for (uint8_t k = 0; k < 5; k++)
+		_fff_write(fifo_stats, startvalue+k);
+	UT_ASSERT(_fff_read_lite(fifo_stats)	== startvalue+1);
+	UT_ASSERT(_fff_read_multiple(fifo_stats, result, 4)	== 3);
+	stats = _fff_stats(fifo_stats);
+	UT_ASSERT(stats.written					== 5);
+	UT_ASSERT(stats.read					== 5);			// including the evicted element
+	UT_ASSERT(stats.dropped					== 1);
+	UT_ASSERT(stats.high_water				== 4);
+	UT_ASSERT(stats.full					== 1);			// staying full is no new transition
+	UT_ASSERT(stats.empty					== 1);
+	
+	// evicting all elements of a full fifo neither empties nor refills it
+	UT_ASSERT(_fff_write_multiple(fifo_stats, multidata, 4)	== 4);
+	UT_ASSERT(_fff_write_multiple(fifo_stats, multidata, 6)	== 4);
+	UT_ASSERT(_fff_add(fifo_stats)			!= NULL);
+	stats = _fff_stats_reset(fifo_stats);
+	UT_ASSERT(stats.written					== 5+4+4+1);
+	UT_ASSERT(stats.read					== 5+4+1);
+	UT_ASSERT(stats.written - stats.read	== _fff_mem_level(fifo_stats));
+	UT_ASSERT(stats.dropped					== 1+6+1);
+	UT_ASSERT(stats.full					== 2);
+	UT_ASSERT(stats.empty					== 1);
+	
+	// reset clears all counters; removing elements counts as read
+	_fff_remove(fifo_stats, 2);
+	_fff_remove_lite(fifo_stats, 2);
+	stats = _fff_stats(fifo_stats);
+	UT_ASSERT(stats.written					== 0);
+	UT_ASSERT(stats.read					== 4);
+	UT_ASSERT(stats.high_water				== 0);
+	UT_ASSERT(stats.empty					== 1);
+	
+	_fff_stats_reset(fifo_stats);
+	_fff_reset(fifo_stats);
+}
+
+void fifofast_test_macro_trace(uint8_t startvalue)
+{
+	uint8_t multidata[5] = {startvalue+1, startvalue+2, startvalue+3, startvalue+4, startvalue+5};
+	uint8_t result[4] = {0};
+	fff_trace_rec_t rec[8];
+	fff_trace_t trace;
+	
+	// nothing is recorded without a recorder
+	_fff_write(fifo_trace, startvalue+0);
+	fff_trace_init(&trace, rec, 8);
+	_fff_trace_attach(fifo_trace, trace);
+	UT_ASSERT(trace.count							== 0);
+	
+	// the count is the amount requested, not the amount moved
+	_fff_write(fifo_trace, startvalue+9);
+	UT_ASSERT(_fff_write_multiple(fifo_trace, multidata, 5)	== 2);
+	UT_ASSERT(_fff_peek(fifo_trace, 2)				== startvalue+1);
+	_fff_peek(fifo_trace, 3) = startvalue+3;							// still a left side operand
+	UT_ASSERT(_fff_read(fifo_trace)					== startvalue+0);
+	UT_ASSERT(_fff_read_multiple(fifo_trace, result, 4)	== 3);
+	UT_ASSERT(result[2]								== startvalue+3);
+	_fff_remove(fifo_trace, 2);
+	_fff_reset(fifo_trace);
+	UT_ASSERT(trace.count							== 8);
+	
+	const uint8_t op[8]		= {FFF_TRACE_WRITE, FFF_TRACE_WRITE, FFF_TRACE_PEEK, FFF_TRACE_PEEK,
+		FFF_TRACE_READ, FFF_TRACE_READ, FFF_TRACE_REMOVE, FFF_TRACE_RESET};
+	const uint32_t count[8]	= {1, 5, 2, 3, 1, 4, 2, 0};
+	for (uint8_t k = 0; k < 8; k++)
+	{
+		UT_ASSERT(FFF_TRACE_OP(rec[k])				== op[k]);
+		UT_ASSERT(FFF_TRACE_COUNT(rec[k])			== count[k]);
+	}
+	
+	// without a flush function further records are lost
+	_fff_rebase(fifo_trace);
+	UT_ASSERT(trace.count							== 8);
+	UT_ASSERT(trace.lost							== 1);
+	
+	_fff_trace_detach(fifo_trace);
+	_fff_write(fifo_trace, startvalue);
+	UT_ASSERT(trace.lost							== 1);
+	
+	_fff_reset(fifo_trace);
+}
+
+void fifofast_test_macro_layout_cl(void)
+{
+	// producer and consumer members must not share a cache line
+	UT_ASSERT(offsetof(struct fff_fifo_spsc_cl_s, write)		% FIFOFAST_CACHE_LINE_SIZE == 0);
+	UT_ASSERT(offsetof(struct fff_fifo_spsc_cl_s, read)		% FIFOFAST_CACHE_LINE_SIZE == 0);
+	UT_ASSERT(offsetof(struct fff_fifo_spsc_cl_s, data)		% FIFOFAST_CACHE_LINE_SIZE == 0);
+	UT_ASSERT(offsetof(struct fff_fifo_spsc_cl_s, read)		!= offsetof(struct fff_fifo_spsc_cl_s, write));
+	UT_ASSERT(offsetof(struct fff_fifo_spsc_cl_s, read_cache)	< offsetof(struct fff_fifo_spsc_cl_s, read));
+	UT_ASSERT(offsetof(struct fff_fifo_spsc_cl_s, write_cache)	< offsetof(struct fff_fifo_spsc_cl_s, data));
+
+	UT_ASSERT(offsetof(struct fff_fifo_mpmc_cl_s, read)		== 1*FIFOFAST_CACHE_LINE_SIZE);
+	UT_ASSERT(offsetof(struct fff_fifo_mpmc_cl_s, seq)		== 2*FIFOFAST_CACHE_LINE_SIZE);
+	UT_ASSERT(offsetof(struct fff_fifo_mpmc_cl_s, data)		% FIFOFAST_CACHE_LINE_SIZE == 0);
+
+	UT_ASSERT(offsetof(struct fff_fifo_mpsc_cl_s, level)		== 1*FIFOFAST_CACHE_LINE_SIZE);
+	UT_ASSERT(offsetof(struct fff_fifo_mpsc_cl_s, read)		== 2*FIFOFAST_CACHE_LINE_SIZE);
+	UT_ASSERT(offsetof(struct fff_fifo_mpsc_cl_s, data)		% FIFOFAST_CACHE_LINE_SIZE == 0);
+}
+
+#ifdef __linux__
+void fifofast_test_macro_mirror(uint8_t startvalue)
+{
+	UT_ASSERT(_fff_mirror_map(fifo_mirror)			== 0);
+	UT_ASSERT(_fff_mem_depth(fifo_mirror)			== FIFOFAST_PAGE_SIZE);
+
+	// move indices close to the end of the array, so the next elements wrap around
+	_fff_write_commit(fifo_mirror, FIFOFAST_PAGE_SIZE-2);
+	_fff_remove_lite(fifo_mirror, FIFOFAST_PAGE_SIZE-2);
+	UT_ASSERT(_fff_is_empty(fifo_mirror)			!= 0);
+
+	for (uint8_t k = 0; k < 5; k++)
+		_fff_write(fifo_mirror, startvalue+k);
+
+	// data wrapped, but is contiguous through the mirror
+	uint8_t* ptr = &_fff_peek(fifo_mirror, 0);
+	for (uint8_t k = 0; k < 5; k++)
+		UT_ASSERT(ptr[k]							== startvalue+k);
+
+	UT_ASSERT(&fifo_mirror.mirror[0]				== &fifo_mirror.data[0] + FIFOFAST_PAGE_SIZE);
+	UT_ASSERT(fifo_mirror.mirror[0]					== startvalue+2);
+	fifo_mirror.mirror[0] = startvalue+0x20;
+	_fff_mirror_sync(fifo_mirror);
+	UT_ASSERT(fifo_mirror.data[0]					== startvalue+0x20);
+
+	// rebase keeps the indices, the data is contiguous already
+	_fff_rebase(fifo_mirror);
+	UT_ASSERT(fifo_mirror.read						== FIFOFAST_PAGE_SIZE-2);
+	UT_ASSERT(_fff_peek(fifo_mirror, 2)				== startvalue+0x20);
+
+	_fff_reset(fifo_mirror);
+	UT_ASSERT(_fff_is_empty(fifo_mirror)			!= 0);
 }
 
+// single access of a fifo declared with FFF_OPT_WAIT, executed by a second thread or the test
+// itself: reads one element to 'data' or writes 'data'
+typedef struct
+{
+	uint8_t data;
+	uint8_t block;					// !0: FFF_WAIT_FOREVER, 0: FFF_WAIT_NONE
+	uint8_t done;					// set after the access succeeded
+} fifofast_test_wait_arg_t;
+
+#define FIFOFAST_TEST_WAIT_ACCESS(V)										\
+static void* fifofast_test_wait_read_##V(void *arg)							\
+{																			\
+	fifofast_test_wait_arg_t *_a = arg;										\
+	if (_fff_##V##_read_wait(fifo_##V##_wait, &_a->data, _a->block ? FFF_WAIT_FOREVER : FFF_WAIT_NONE))	\
+		__atomic_store_n(&_a->done, 1, __ATOMIC_RELEASE);					\
+	return NULL;															\
+}																			\
+static void* fifofast_test_wait_write_##V(void *arg)						\
+{																			\
+	fifofast_test_wait_arg_t *_a = arg;										\
+	if (_fff_##V##_write_wait(fifo_##V##_wait, _a->data, _a->block ? FFF_WAIT_FOREVER : FFF_WAIT_NONE))	\
+		__atomic_store_n(&_a->done, 1, __ATOMIC_RELEASE);					\
+	return NULL;															\
+}
+
+FIFOFAST_TEST_WAIT_ACCESS(spsc)
+FIFOFAST_TEST_WAIT_ACCESS(mpmc)
+FIFOFAST_TEST_WAIT_ACCESS(mpsc)
+
+// waits up to 1s until '*word' is !0; returns the last value
+static uint32_t fifofast_test_wait_for(void *word, uint8_t size)
+{
+	uint32_t value = 0;
+	for (uint16_t k = 0; k < 10000 && value == 0; k++)
+	{
+		value = (size == 1) ? __atomic_load_n((uint8_t*)word, __ATOMIC_ACQUIRE)
+			: __atomic_load_n((uint32_t*)word, __ATOMIC_ACQUIRE);
+		if (value == 0)
+			nanosleep(&(struct timespec){0, 100000}, NULL);
+	}
+	return value;
+}
+
+// lets a second thread block on the empty fifo until the test writes, then on the full fifo until
+// the test reads. Returns !0 if both threads slept and were woken up with the right data.
+static uint8_t fifofast_test_wait_threads(void* (*read_fn)(void*), void* (*write_fn)(void*),
+	fff_wait_t *wait, uint8_t startvalue)
+{
+	fifofast_test_wait_arg_t consumer = {0, 1, 0};
+	fifofast_test_wait_arg_t producer = {startvalue, 0, 0};
+	uint8_t result = 1;
+	pthread_t thread;
+
+	// consumer sleeps on the empty fifo, the write wakes it up
+	if (pthread_create(&thread, NULL, read_fn, &consumer) != 0)
+		return 0;
+	result &= fifofast_test_wait_for(&wait->waiters[FFF_WAIT_DATA], 4) != 0;
+	result &= __atomic_load_n(&consumer.done, __ATOMIC_ACQUIRE) == 0;
+	write_fn(&producer);
+	if (fifofast_test_wait_for(&consumer.done, 1) == 0)
+		return 0;						// thread still blocked, don't join
+	pthread_join(thread, NULL);
+	result &= consumer.data == startvalue;
+
+	// fill the fifo, then the producer sleeps until the read makes space
+	for (uint8_t k = 1; producer.done; k++)
+	{
+		producer.data = startvalue+k;
+		producer.done = 0;
+		write_fn(&producer);
+	}
+	producer.data	= startvalue;
+	producer.block	= 1;
+	if (pthread_create(&thread, NULL, write_fn, &producer) != 0)
+		return 0;
+	result &= fifofast_test_wait_for(&wait->waiters[FFF_WAIT_SPACE], 4) != 0;
+	result &= __atomic_load_n(&producer.done, __ATOMIC_ACQUIRE) == 0;
+	consumer.block = 0;
+	consumer.done = 0;
+	read_fn(&consumer);
+	result &= consumer.data == startvalue+1;
+	if (fifofast_test_wait_for(&producer.done, 1) == 0)
+		return 0;
+	pthread_join(thread, NULL);
+
+	// the element of the producer is the last one; the fifo is empty afterwards
+	do
+	{
+		result &= consumer.done != 0;
+		consumer.done = 0;
+		read_fn(&consumer);
+	} while (consumer.done);
+	result &= consumer.data == startvalue;
+	return result;
+}
+
+void fifofast_test_macro_wait(uint8_t startvalue)
+{
+	uint8_t result = 0;
+	
+	UT_ASSERT(((uintptr_t)&fifo_spsc_wait.wait[0]) % 4	== 0);	// futex words aligned, even if packed
+	
+	// without timeout the macros behave like the non-blocking ones
+	UT_ASSERT(_fff_spsc_read_wait(fifo_spsc_wait, &result, FFF_WAIT_NONE)	== 0);
+	for (uint8_t k = 0; k < 4; k++)
+		UT_ASSERT(_fff_spsc_write_wait(fifo_spsc_wait, startvalue+k, FFF_WAIT_NONE)	!= 0);
+	UT_ASSERT(_fff_spsc_write_wait(fifo_spsc_wait, startvalue+4, FFF_WAIT_NONE)	== 0);
+	
+	// no other thread: wait 1ms, then give up
+	UT_ASSERT(_fff_spsc_write_wait(fifo_spsc_wait, startvalue+4, 1000000)	== 0);
+	UT_ASSERT(fifo_spsc_wait.wait[0].waiters[FFF_WAIT_SPACE]				== 0);
+	
+	for (uint8_t k = 0; k < 4; k++)
+	{
+		UT_ASSERT(_fff_spsc_read_wait(fifo_spsc_wait, &result, FFF_WAIT_FOREVER)	!= 0);
+		UT_ASSERT(result								== startvalue+k);
+	}
+	UT_ASSERT(_fff_spsc_read_wait(fifo_spsc_wait, &result, 1000000)		== 0);
+	UT_ASSERT(result									== startvalue+3);	// unchanged
+	UT_ASSERT(fifo_spsc_wait.wait[0].waiters[FFF_WAIT_DATA]				== 0);
+	
+	// a second thread sleeps in FFF_WAIT_FOREVER until it is woken up by the other side
+	UT_ASSERT(fifofast_test_wait_threads(fifofast_test_wait_read_spsc, fifofast_test_wait_write_spsc,
+		&fifo_spsc_wait.wait[0], startvalue)	!= 0);
+	UT_ASSERT(fifofast_test_wait_threads(fifofast_test_wait_read_mpmc, fifofast_test_wait_write_mpmc,
+		&fifo_mpmc_wait.wait[0], startvalue)	!= 0);
+	UT_ASSERT(fifofast_test_wait_threads(fifofast_test_wait_read_mpsc, fifofast_test_wait_write_mpsc,
+		&fifo_mpsc_wait.wait[0], startvalue)	!= 0);
+}
+
+void fifofast_test_macro_event(uint8_t startvalue)
+{
+	uint64_t count = 0;
+	
+	_fff_event_ack(fifo_event);											// not open: no effect
+	UT_ASSERT(_fff_event_open(fifo_event, 1)		== 0);
+	UT_ASSERT(read(_fff_event_fd(fifo_event), &count, sizeof(count))	< 0);	// not readable
+	
+	// a burst of writes is signaled once
+	for (uint16_t k = 0; k < 1000; k++)
+	{
+		_fff_write(fifo_event, startvalue+k);
+		_fff_event_notify(fifo_event);
+	}
+	UT_ASSERT(read(_fff_event_fd(fifo_event), &count, sizeof(count))	== sizeof(count));
+	UT_ASSERT(count									== 1);
+	
+	// data left after the acknowledge is signaled again
+	_fff_event_ack(fifo_event);
+	UT_ASSERT(read(_fff_event_fd(fifo_event), &count, sizeof(count))	== sizeof(count));
+	_fff_reset(fifo_event);
+	_fff_event_ack(fifo_event);
+	UT_ASSERT(read(_fff_event_fd(fifo_event), &count, sizeof(count))	< 0);
+	_fff_event_close(fifo_event);
+	
+	// with a threshold of 4 the 4th element is signaled
+	UT_ASSERT(_fff_event_open(fifo_event, 4)		== 0);
+	for (uint8_t k = 0; k < 3; k++)
+	{
+		_fff_write(fifo_event, startvalue+k);
+		_fff_event_notify(fifo_event);
+	}
+	UT_ASSERT(read(_fff_event_fd(fifo_event), &count, sizeof(count))	< 0);
+	_fff_write(fifo_event, startvalue+3);
+	_fff_event_notify(fifo_event);
+	UT_ASSERT(read(_fff_event_fd(fifo_event), &count, sizeof(count))	== sizeof(count));
+	
+	_fff_event_close(fifo_event);
+	_fff_reset(fifo_event);
+	
+	// resetting a lock-free fifo keeps its eventfd and the notifications
+	UT_ASSERT(_fff_event_open(fifo_mpmc_event, 1)	== 0);
+	int fd = _fff_event_fd(fifo_mpmc_event);
+	UT_ASSERT(_fff_mpmc_write(fifo_mpmc_event, startvalue)	!= 0);
+	_fff_mpmc_reset(fifo_mpmc_event);
+	UT_ASSERT(_fff_mpmc_is_empty(fifo_mpmc_event)	!= 0);
+	UT_ASSERT(_fff_event_fd(fifo_mpmc_event)		== fd);
+	UT_ASSERT(_fff_mpmc_write(fifo_mpmc_event, startvalue)	!= 0);
+	_fff_mpmc_event_notify(fifo_mpmc_event);
+	UT_ASSERT(read(fd, &count, sizeof(count))		== sizeof(count));
+	_fff_event_close(fifo_mpmc_event);
+	_fff_mpmc_reset(fifo_mpmc_event);
+	
+	UT_ASSERT(_fff_event_open(fifo_mpsc_event, 1)	== 0);
+	fd = _fff_event_fd(fifo_mpsc_event);
+	UT_ASSERT(_fff_mpsc_write(fifo_mpsc_event, startvalue)	!= 0);
+	_fff_mpsc_reset(fifo_mpsc_event);
+	UT_ASSERT(_fff_mpsc_is_empty(fifo_mpsc_event)	!= 0);
+	UT_ASSERT(_fff_mpsc_mem_level(fifo_mpsc_event)	== 0);
+	UT_ASSERT(_fff_event_fd(fifo_mpsc_event)		== fd);
+	UT_ASSERT(_fff_mpsc_write(fifo_mpsc_event, startvalue)	!= 0);
+	_fff_mpsc_event_notify(fifo_mpsc_event);
+	UT_ASSERT(read(fd, &count, sizeof(count))		== sizeof(count));
+	_fff_event_close(fifo_mpsc_event);
+	_fff_mpsc_reset(fifo_mpsc_event);
+}
+
+void fifofast_test_macro_latency(uint8_t startvalue)
+{
+	uint8_t result[4];
+	fff_latency_t latency;
+	
+	// every element leaving the fifo is measured, no matter how
+	for (uint8_t k = 0; k < 6; k++)
+		_fff_write(fifo_latency, startvalue+k);				// 2 elements dismissed
+	UT_ASSERT(_fff_read(fifo_latency)				== startvalue);
+	UT_ASSERT(_fff_read_multiple(fifo_latency, result, 2)	== 2);
+	_fff_remove(fifo_latency, 1);
+	latency = _fff_latency(fifo_latency);
+	UT_ASSERT(latency.count							== 4);
+	UT_ASSERT(latency.p50							<= latency.p99);
+	UT_ASSERT(latency.p99							<= latency.p999);
+	UT_ASSERT(latency.p999							<= latency.max);
+	
+	// percentiles are the upper bound of their bucket: 1/8 power of two
+	_fff_latency_reset(fifo_latency);
+	UT_ASSERT(_fff_latency(fifo_latency).count		== 0);
+	for (uint16_t k = 0; k < 1000; k++)
+		fff_latency_record(_FFF_LATENCY_HIST(fifo_latency), k);
+	latency = _fff_latency(fifo_latency);
+	UT_ASSERT(latency.count							== 1000);
+	UT_ASSERT(latency.p50							== 511);	// 499 in [480, 511]
+	UT_ASSERT(latency.p99							== 1023);	// 989 in [960, 1023]
+	UT_ASSERT(latency.max							== 1023);
+	UT_ASSERT(_fff_latency_percentile(fifo_latency, 5)	== 4);	// small values are exact
+	
+	_fff_latency_reset(fifo_latency);
+	_fff_reset(fifo_latency);
+}
+
+void fifofast_test_macro_perf(uint8_t startvalue)
+{
+	fff_perf_t perf;
+	uint8_t available = _fff_perf_open(perf, fifo_uint8);
+	
+	// works with or without hardware counters (e.g. in a container)
+	UT_ASSERT(available								<= FFF_PERF_EVENTS);
+	UT_ASSERT(perf.name[0]							== 'f');	// "fifo_uint8"
+	UT_ASSERT(_fff_perf_per_op(perf, FFF_PERF_CYCLES)	< 0);		// no operations yet
+	
+	_fff_perf_begin(perf);
+	for (uint8_t k = 0; k < 4; k++)
+		_fff_write(fifo_uint8, startvalue+k);
+	_fff_perf_end(perf, 4);
+	_fff_perf_begin(perf);
+	UT_ASSERT(_fff_read(fifo_uint8)					== startvalue);
+	_fff_perf_end(perf, 1);
+	UT_ASSERT(perf.ops								== 5);
+	for (uint8_t k = 0; k < FFF_PERF_EVENTS; k++)
+		UT_ASSERT((_fff_perf_per_op(perf, k) < 0)	== (perf.fd[k] < 0));
+	
+	// closed counters are reported as not available, the sums are kept until reset
+	_fff_perf_close(perf);
+	UT_ASSERT(_fff_perf_per_op(perf, FFF_PERF_INSTRUCTIONS)	< 0);
+	_fff_perf_reset(perf);
+	UT_ASSERT(perf.ops								== 0);
+	
+	_fff_reset(fifo_uint8);
+}
+
+void fifofast_test_macro_trace_file(uint8_t startvalue)
+{
+	const char *path = "/tmp/fifofast_test.trace";
+	fff_trace_header_t header;
+	fff_trace_rec_t rec[4];
+	fff_trace_t trace;
+	
+	UT_ASSERT(_fff_trace_open(fifo_trace, trace, path)	== 0);
+	_fff_write(fifo_trace, startvalue);
+	_fff_write(fifo_trace, startvalue);
+	_fff_remove(fifo_trace, 2);
+	UT_ASSERT(_fff_trace_close(fifo_trace, trace)	== 0);
+	_fff_write(fifo_trace, startvalue);								// not recorded anymore
+	
+	// the file contains the header and all records
+	int fd = open(path, O_RDONLY);
+	UT_ASSERT(read(fd, &header, sizeof(header))		== sizeof(header));
+	UT_ASSERT(memcmp(header.magic, "FFFT", 4)		== 0);
+	UT_ASSERT(header.elem_size						== 1);
+	UT_ASSERT(header.depth							== 4);
+	UT_ASSERT(header.options						== FFF_OPT_TRACE);
+	UT_ASSERT(read(fd, rec, sizeof(rec))			== 3*sizeof(rec[0]));
+	UT_ASSERT(FFF_TRACE_OP(rec[2])					== FFF_TRACE_REMOVE);
+	UT_ASSERT(FFF_TRACE_COUNT(rec[2])				== 2);
+	close(fd);
+	unlink(path);
+	
+	_fff_reset(fifo_trace);
+}
+#endif
+
 //////////////////////////////////////////////////////////////////////////
 // Test Functions
 //////////////////////////////////////////////////////////////////////////
@@ -601,3 +1850,39 @@ void fifofast_test_func_remove(fff_proto_t* fifo, uint8_t startvalue)
 	UT_ASSERT(fff_is_full(fifo)				== 0);
 
 }
+
+void fifofast_test_func_multiple(fff_proto_t* fifo, uint8_t startvalue)
+{
+	uint8_t multidata[5] = {startvalue+0, startvalue+1, startvalue+2, startvalue+3, startvalue+4};
+	uint8_t result[5] = {0};
+	
+	// offset the indices, so the data wraps around the end of the array
+	fff_write_lite(fifo, &multidata[0]);
+	fff_write_lite(fifo, &multidata[0]);
+	fff_write_lite(fifo, &multidata[0]);
+	fff_remove_lite(fifo, 3);
+	
+	UT_ASSERT(fff_write_multiple(fifo, multidata, 5)	== 4);		// 5th element is dismissed
+	UT_ASSERT(fff_mem_level(fifo)			== 4);
+	UT_ASSERT(fff_is_full(fifo)				!= 0);
+	UT_ASSERT(*(uint8_t*)fff_peek_read(fifo, 3)		== startvalue+3);
+	
+	UT_ASSERT(fff_read_multiple(fifo, result, 3)		== 3);
+	UT_ASSERT(result[0]						== startvalue+0);
+	UT_ASSERT(result[2]						== startvalue+2);
+	UT_ASSERT(fff_read_multiple(fifo, result, 5)		== 1);
+	UT_ASSERT(result[0]						== startvalue+3);
+	UT_ASSERT(fff_is_empty(fifo)			!= 0);
+	
+	// rebase a wrapped fifo; elements must be in order at physical index 0
+	UT_ASSERT(fff_write_multiple(fifo, multidata, 3)	== 3);
+	UT_ASSERT(fff_linearize(fifo, result)	== 3);
+	UT_ASSERT(result[2]						== startvalue+2);
+	fff_rebase(fifo);
+	UT_ASSERT(fff_peek_read(fifo, 0)		== fifo->data);
+	UT_ASSERT(fifo->data[0]					== startvalue+0);
+	UT_ASSERT(fifo->data[2]					== startvalue+2);
+	UT_ASSERT(fff_mem_level(fifo)			== 3);
+	
+	fff_reset(fifo);
+}
@@ -0,0 +1,195 @@
+/*
+ * fifofast_test.cpp
+ *
+ * Created: 17.10.2026 21:14:52
+ *
+ * Description:
+ * Automated tests of fifofast.hpp powered by unittrace. They are called from C like the tests in
+ * fifofast_test.c and need a C++17 compiler, see 'FIFOFAST_TEST_CPP' in fifofast_test.h.
+ */
+
+#include "fifofast.hpp"
+
+#include <memory>		// required for std::unique_ptr
+#include <string>		// required for std::string
+
+// unittrace.h is C only ('typeof', tentative definitions of its globals), so only the function behind
+// 'UT_ASSERT(cond)' is declared here. Failed asserts end up in the same list as those of C.
+extern "C" void ut_assert_manual(void* addr, uint8_t cond);
+#define UT_ASSERT(cond)		do{__label__ lcl; lcl: ut_assert_manual(&&lcl, cond);}while(0)
+
+
+//////////////////////////////////////////////////////////////////////////
+// Helper Types
+//////////////////////////////////////////////////////////////////////////
+
+// element which counts its living instances, so missing or extra destructor calls are detected
+struct fifofast_test_counted
+{
+	static int alive;
+	uint8_t value;
+
+	fifofast_test_counted(uint8_t value) : value(value)						{ alive++; }
+	fifofast_test_counted(const fifofast_test_counted &other) : value(other.value)	{ alive++; }
+	fifofast_test_counted& operator=(const fifofast_test_counted &other)		{ value = other.value; return *this; }
+	~fifofast_test_counted()												{ alive--; }
+};
+
+int fifofast_test_counted::alive = 0;
+
+
+//////////////////////////////////////////////////////////////////////////
+// Test Class Template
+//////////////////////////////////////////////////////////////////////////
+
+// same layout rules as _fff_declare(...)
+static_assert(fifofast<uint8_t, 4>::mem_depth()		== 4);
+static_assert(fifofast<uint8_t, 6>::mem_depth()		== 8);
+static_assert(sizeof(fifofast<uint8_t, 4>)			== 3+4);
+static_assert(sizeof(fifofast<uint8_t, 256>)		== 1+1+2+256);
+
+extern "C" void fifofast_test_cpp_trivial(uint8_t startvalue)
+{
+	fifofast<uint8_t, 4> fifo;
+	uint8_t value = 0;
+
+	UT_ASSERT(fifo.mem_level()		== 0);
+	UT_ASSERT(fifo.is_empty()		!= 0);
+	UT_ASSERT(fifo.try_pop(value)	== false);
+	UT_ASSERT(value					== 0);			// unchanged
+
+	// fill with all variants of adding an element
+	UT_ASSERT(fifo.emplace(startvalue)	== startvalue);
+	UT_ASSERT(*fifo.try_emplace(startvalue+1)	== startvalue+1);
+	UT_ASSERT(fifo.push(startvalue+2)	== true);
+	value = startvalue+3;
+	UT_ASSERT(fifo.push(value)			== true);
+	UT_ASSERT(fifo.is_full()			!= 0);
+	UT_ASSERT(fifo.mem_free()			== 0);
+
+	// full: nothing is added
+	UT_ASSERT(fifo.push(startvalue+4)	== false);
+	UT_ASSERT(fifo.try_emplace(startvalue+4)	== nullptr);
+	UT_ASSERT(fifo.mem_level()			== 4);
+
+	// peek is writable and does not remove
+	UT_ASSERT(fifo.peek(0)				== startvalue);
+	UT_ASSERT(fifo.peek(3)				== startvalue+3);
+	fifo.peek(1) = startvalue+9;
+	UT_ASSERT(fifo.mem_level()			== 4);
+
+	UT_ASSERT(fifo.pop()				== startvalue);
+	UT_ASSERT(fifo.try_pop(value)		== true);
+	UT_ASSERT(value						== startvalue+9);
+	UT_ASSERT(fifo.mem_level()			== 2);
+
+	// remove is limited to the current level
+	fifo.remove(1);
+	UT_ASSERT(fifo.peek(0)				== startvalue+3);
+	fifo.remove(5);
+	UT_ASSERT(fifo.is_empty()			!= 0);
+
+	// nothing to copy: the pointers are not touched
+	UT_ASSERT(fifo.write_multiple(nullptr, 0)	== 0);
+	UT_ASSERT(fifo.read_multiple(nullptr, 0)	== 0);
+	UT_ASSERT(fifo.is_empty()					!= 0);
+
+	// write/ read multiple across the end of the array (read and write index are 0 now)
+	uint8_t src[6] = {startvalue, (uint8_t)(startvalue+1), (uint8_t)(startvalue+2),
+		(uint8_t)(startvalue+3), (uint8_t)(startvalue+4), (uint8_t)(startvalue+5)};
+	uint8_t dst[6] = {0};
+	UT_ASSERT(fifo.write_multiple(src, 3)	== 3);
+	UT_ASSERT(fifo.read_multiple(dst, 2)	== 2);
+	UT_ASSERT(dst[1]						== startvalue+1);
+	UT_ASSERT(fifo.write_multiple(src, 6)	== 3);		// only 3 free, wraps after the first
+	UT_ASSERT(fifo.is_full()				!= 0);
+	UT_ASSERT(fifo.read_multiple(dst, 6)	== 4);
+	UT_ASSERT(dst[0]						== startvalue+2);
+	UT_ASSERT(dst[1]						== startvalue);
+	UT_ASSERT(dst[3]						== startvalue+2);
+	UT_ASSERT(fifo.is_empty()				!= 0);
+
+	fifo.emplace(startvalue);
+	fifo.reset();
+	UT_ASSERT(fifo.is_empty()				!= 0);
+}
+
+extern "C" void fifofast_test_cpp_object(uint8_t startvalue)
+{
+	// std::string: elements are moved in and out
+	{
+		fifofast<std::string, 4> fifo;
+		std::string value;
+
+		UT_ASSERT(fifo.emplace(40, 'a').size()		== 40);		// too long for small string storage
+		UT_ASSERT(fifo.try_emplace("b")				!= nullptr);
+		UT_ASSERT(fifo.push(std::string(1, 'c'))	== true);
+		UT_ASSERT(fifo.push("d")					== true);
+		UT_ASSERT(fifo.push("e")					== false);
+		UT_ASSERT(fifo.try_emplace("e")				== nullptr);
+
+		UT_ASSERT(fifo.peek(1)						== "b");
+		UT_ASSERT(fifo.pop()						== std::string(40, 'a'));
+		UT_ASSERT(fifo.try_pop(value)				== true);
+		UT_ASSERT(value								== "b");
+		fifo.remove(1);
+		UT_ASSERT(fifo.peek(0)						== "d");
+
+		std::string src[3] = {"x", "y", "z"};
+		std::string dst[4];
+		UT_ASSERT(fifo.write_multiple(src, 3)		== 3);
+		UT_ASSERT(fifo.read_multiple(dst, 4)		== 4);
+		UT_ASSERT(dst[0]							== "d");
+		UT_ASSERT(dst[3]							== "z");
+		UT_ASSERT(src[2]							== "z");	// copied, not moved
+		UT_ASSERT(fifo.try_pop(value)				== false);
+		UT_ASSERT(value								== "b");
+	}
+
+	// move-only type
+	{
+		fifofast<std::unique_ptr<uint8_t>, 4> fifo;
+		for (uint8_t k = 0; k < 6; k++)
+		{
+			UT_ASSERT(fifo.push(std::make_unique<uint8_t>(startvalue+k))	== true);
+			UT_ASSERT(*fifo.pop()										== startvalue+k);
+		}
+		fifo.emplace(new uint8_t(startvalue));
+		std::unique_ptr<uint8_t> value;
+		UT_ASSERT(fifo.try_pop(value)		== true);
+		UT_ASSERT(*value					== startvalue);
+	}
+
+	// every constructed element is destroyed exactly once
+	{
+		fifofast<fifofast_test_counted, 8> fifo;
+		for (uint8_t k = 0; k < 7; k++)
+			fifo.emplace(startvalue+k);
+		UT_ASSERT(fifofast_test_counted::alive		== 7);
+
+		fifo.remove(2);
+		UT_ASSERT(fifofast_test_counted::alive		== 5);
+		UT_ASSERT(fifo.peek(0).value				== startvalue+2);
+
+		fifofast_test_counted value(0);
+		UT_ASSERT(fifo.try_pop(value)				== true);
+		UT_ASSERT(value.value						== startvalue+2);
+		UT_ASSERT(fifofast_test_counted::alive		== 5);		// 4 stored + 'value'
+
+		fifofast<fifofast_test_counted, 8> copy = fifo;
+		UT_ASSERT(fifofast_test_counted::alive		== 9);
+		UT_ASSERT(copy.pop().value					== startvalue+3);
+		UT_ASSERT(fifofast_test_counted::alive		== 8);
+
+		fifofast_test_counted dst[2] = {0, 0};
+		UT_ASSERT(copy.read_multiple(dst, 2)		== 2);
+		UT_ASSERT(dst[1].value						== startvalue+5);
+		UT_ASSERT(copy.write_multiple(dst, 2)		== 2);
+		UT_ASSERT(fifofast_test_counted::alive		== 10);		// copied, not moved
+
+		copy.reset();
+		fifo.remove(1);
+		UT_ASSERT(fifofast_test_counted::alive		== 6);		// 3 stored + 'value' + 'dst'
+	}
+	UT_ASSERT(fifofast_test_counted::alive			== 0);
+}
@@ -15,6 +15,38 @@
 #include "fifofast_demo.h"
 #include "unittrace/unittrace.h"
 
+//////////////////////////////////////////////////////////////////////////
+// Settings
+//////////////////////////////////////////////////////////////////////////
+
+// performance budgets in cycles of 'UT_CYCLES()'. A test fails if even the fastest access takes
+// longer. Unoptimized and instrumented builds (-O0, AddressSanitizer) get larger budgets. Both can
+// be overwritten as compiler flags to catch smaller regressions of a certain build.
+#ifndef FIFOFAST_TEST_CYCLES_WRITE
+	#if defined(__OPTIMIZE__) && !defined(__SANITIZE_ADDRESS__)
+		#define FIFOFAST_TEST_CYCLES_WRITE		150
+	#else
+		#define FIFOFAST_TEST_CYCLES_WRITE		500
+	#endif
+#endif
+#ifndef FIFOFAST_TEST_CYCLES_REBASE
+	#if defined(__OPTIMIZE__) && !defined(__SANITIZE_ADDRESS__)
+		#define FIFOFAST_TEST_CYCLES_REBASE		2000
+	#else
+		#define FIFOFAST_TEST_CYCLES_REBASE		5000
+	#endif
+#endif
+
+// fifofast_test.cpp tests fifofast.hpp and must be compiled with a C++17 compiler. The avr-gcc
+// toolchain has no C++ standard library, so it is only linked by default in other builds.
+#ifndef FIFOFAST_TEST_CPP
+	#ifdef __AVR__
+		#define FIFOFAST_TEST_CPP			0
+	#else
+		#define FIFOFAST_TEST_CPP			1
+	#endif
+#endif
+
 //////////////////////////////////////////////////////////////////////////
 // Function Declarations
 //////////////////////////////////////////////////////////////////////////
@@ -28,11 +60,41 @@ void fifofast_test_macro_remove_lite(uint8_t startvalue);
 void fifofast_test_macro_remove(uint8_t startvalue);
 void fifofast_test_macro_rebase(uint8_t startvalue);
 void fifofast_test_macro_write_multiple(uint8_t startvalue);
+void fifofast_test_macro_read_multiple(uint8_t startvalue);
+void fifofast_test_macro_span(uint8_t startvalue);
+void fifofast_test_macro_spsc(uint8_t startvalue);
+void fifofast_test_macro_spsc_batch(uint8_t startvalue);
+void fifofast_test_macro_spsc_mixed(uint8_t startvalue);
+void fifofast_test_macro_mpmc(uint8_t startvalue);
+void fifofast_test_macro_mpsc(uint8_t startvalue);
+void fifofast_test_macro_exact(uint8_t startvalue);
+void fifofast_test_macro_options(uint8_t startvalue);
+void fifofast_test_macro_record(uint8_t startvalue);
+void fifofast_test_macro_bip(uint8_t startvalue);
+void fifofast_test_macro_pq(uint8_t startvalue);
+void fifofast_test_macro_soa(uint8_t startvalue);
+void fifofast_test_macro_stats(uint8_t startvalue);
+void fifofast_test_macro_trace(uint8_t startvalue);
+void fifofast_test_macro_layout_cl(void);
+#ifdef __linux__
+void fifofast_test_macro_mirror(uint8_t startvalue);
+void fifofast_test_macro_wait(uint8_t startvalue);
+void fifofast_test_macro_event(uint8_t startvalue);
+void fifofast_test_macro_latency(uint8_t startvalue);
+void fifofast_test_macro_perf(uint8_t startvalue);
+void fifofast_test_macro_trace_file(uint8_t startvalue);
+#endif
+
+#if FIFOFAST_TEST_CPP
+void fifofast_test_cpp_trivial(uint8_t startvalue);
+void fifofast_test_cpp_object(uint8_t startvalue);
+#endif
 
 void fifofast_test_func_initial(fff_proto_t* fifo);
 void fifofast_test_func_write(fff_proto_t* fifo, uint8_t startvalue);
 void fifofast_test_func_peek(fff_proto_t* fifo, uint8_t startvalue);
 void fifofast_test_func_remove_lite(fff_proto_t* fifo, uint8_t startvalue);
 void fifofast_test_func_remove(fff_proto_t* fifo, uint8_t startvalue);
+void fifofast_test_func_multiple(fff_proto_t* fifo, uint8_t startvalue);
 
 #endif /* FIFOFAST_TEST_H_ */
\ No newline at end of file
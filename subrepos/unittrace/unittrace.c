@@ -8,6 +8,7 @@
 
 #include "unittrace.h"
 #include <stddef.h>		// required for 'NULL'
+#include <string.h>		// required for strcmp(), memset()
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -16,6 +17,7 @@
 
 volatile void* unittrace_array[UNITTRACE_LIST_SIZE] = {[0 ... UNITTRACE_LIST_SIZE-1] = NULL};
 ut_cnt_t unittrace_count = 0;
+ut_time_t unittrace_time[UNITTRACE_TIME_SIZE];
 
 
 //////////////////////////////////////////////////////////////////////////
@@ -59,4 +61,71 @@ void* ut_get_array(void)
 ut_cnt_t ut_get_count(void)
 {
 	return unittrace_count;
-}
\ No newline at end of file
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Timing
+//////////////////////////////////////////////////////////////////////////
+
+// starts the cycle counter, if it needs to be enabled first
+static void ut_cycles_init(void)
+{
+	#if defined(UNITTRACE_CYCLES_CUSTOM)
+		// started by the user
+	#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+		*(volatile uint32_t*)0xE000EDFC |= (1ul<<24);	// CoreDebug->DEMCR: TRCENA
+		*(volatile uint32_t*)0xE0001000 |= (1ul<<0);	// DWT->CTRL: CYCCNTENA
+	#elif defined(__AVR__)
+		TCCR1A = 0;
+		TCCR1B = (1<<CS10);								// normal mode, no prescaler
+	#endif
+}
+
+ut_time_t* ut_time_get(const char* label, uint8_t add)
+{
+	uint8_t k;
+	for (k = 0; k < UNITTRACE_TIME_SIZE && unittrace_time[k].label != NULL; k++)
+	{
+		if (unittrace_time[k].label == label || strcmp(unittrace_time[k].label, label) == 0)
+			return &unittrace_time[k];
+	}
+	
+	// label not found, add it to the first unused entry
+	if (!add || k == UNITTRACE_TIME_SIZE)
+		return NULL;
+	if (k == 0)
+		ut_cycles_init();
+	unittrace_time[k].label	= label;
+	unittrace_time[k].min	= (ut_cycles_t)-1;
+	return &unittrace_time[k];
+}
+
+void ut_time_add(const char* label, ut_cycles_t end)
+{
+	ut_time_t* t = ut_time_get(label, 0);
+	if (t == NULL)
+		return;
+	
+	// unsigned subtraction is correct even if the counter overflowed once
+	ut_cycles_t cycles = end - t->start;
+	if (cycles < t->min)
+		t->min = cycles;
+	if (cycles > t->max)
+		t->max = cycles;
+	t->count++;
+	t->sum += cycles;
+}
+
+uint8_t ut_time_check(const char* label, uint32_t max)
+{
+	ut_time_t* t = ut_time_get(label, 0);
+	if (t == NULL || t->count == 0)
+		return 0;
+	return !UNITTRACE_CYCLES_AVAILABLE || t->min <= max;
+}
+
+void ut_time_reset(void)
+{
+	memset(unittrace_time, 0, sizeof(unittrace_time));
+}
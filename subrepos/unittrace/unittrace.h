@@ -22,6 +22,10 @@
 
 
 #include <stdint.h>		// required for data types (uint8_t, uint16_t, ...)
+#include <stddef.h>		// required for 'NULL'
+#if defined(__AVR__)
+	#include <avr/io.h>		// required for 'TCNT1', 'TCCR1B'
+#endif
 #include "utility/macros/com/macro_type.h"
 
 
@@ -41,7 +45,7 @@
 
 // version numbering is based on "Semantic Versioning 2.0.0" (semver.org)
 #define UNITTRACE_VERSION_MAJOR		0
-#define UNITTRACE_VERSION_MINOR		1
+#define UNITTRACE_VERSION_MINOR		2
 #define UNITTRACE_VERSION_PATCH		0
 #define UNITTRACE_VERSION_SUFFIX	
 #define UNITTRACE_VERSION_META
@@ -71,6 +75,63 @@ typedef UNITTRACE_COUNTER_TYPE ut_cnt_t;
 // increase the assert execution time slightly.
 #define UNITTRACE_USE_EXT_COUNTER
 
+// Define the amount of labels timed with 'UT_TIME_BEGIN(label)'/'UT_TIME_END(label)'. Each label
+// requires 20 (AVR8) to 48 (64bit) byte of RAM. Further labels are ignored once the table is full.
+#define UNITTRACE_TIME_SIZE		8
+
+
+//////////////////////////////////////////////////////////////////////////
+// Cycle Counter
+//////////////////////////////////////////////////////////////////////////
+
+// 'UT_CYCLES()' returns the current value of a free running counter of the type 'ut_cycles_t':
+//  - x86:			time stamp counter (rdtsc), counts at a constant rate close to the core clock
+//  - ARMv7-M/8-M:	DWT cycle counter (CYCCNT), enabled on first use
+//  - ARMv8-A:		virtual counter (cntvct_el0), counts at a fixed rate below the core clock
+//  - AVR8:			16bit timer 1, set to run at the core clock on first use. Regions longer than
+//					65535 cycles overflow, and timer 1 can't be used by the application.
+// To use any other counter, define 'UT_CYCLES()' and 'UNITTRACE_CYCLES_TYPE' as compiler flags, so
+// unittrace.c sees them, too. Without a counter all regions take 0 cycles and 'UT_ASSERT_CYCLES()'
+// always passes.
+#if defined(UT_CYCLES)
+	#define UNITTRACE_CYCLES_AVAILABLE	1
+	#define UNITTRACE_CYCLES_CUSTOM
+#elif defined(__x86_64__) || defined(__i386__)
+	#define UNITTRACE_CYCLES_TYPE		uint64_t
+	#define UNITTRACE_CYCLES_AVAILABLE	1
+	#define UT_CYCLES()					__builtin_ia32_rdtsc()
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+	#define UNITTRACE_CYCLES_TYPE		uint32_t
+	#define UNITTRACE_CYCLES_AVAILABLE	1
+	#define UT_CYCLES()					(*(volatile uint32_t*)0xE0001004)	// DWT->CYCCNT
+#elif defined(__aarch64__)
+	#define UNITTRACE_CYCLES_TYPE		uint64_t
+	#define UNITTRACE_CYCLES_AVAILABLE	1
+	#define UT_CYCLES()					({uint64_t _ut_c; asm volatile("mrs %0, cntvct_el0" : "=r"(_ut_c)); _ut_c;})
+#elif defined(__AVR__)
+	#define UNITTRACE_CYCLES_TYPE		uint16_t
+	#define UNITTRACE_CYCLES_AVAILABLE	1
+	#define UT_CYCLES()					TCNT1
+#else
+	#define UNITTRACE_CYCLES_TYPE		uint32_t
+	#define UNITTRACE_CYCLES_AVAILABLE	0
+	#define UT_CYCLES()					0
+#endif
+
+// extra '#define UNITTRACE_CYCLES_TYPE' prevents VAssistX from marking 'ut_cycles_t' red
+typedef UNITTRACE_CYCLES_TYPE ut_cycles_t;
+
+// timing of a single label
+typedef struct
+{
+	const char* label;		// name of the timed region, NULL: unused
+	ut_cycles_t start;		// counter value at 'UT_TIME_BEGIN(label)'
+	ut_cycles_t min;		// shortest region
+	ut_cycles_t max;		// longest region
+	uint32_t count;			// amount of regions
+	uint64_t sum;			// sum of all regions, 'sum/count' is the average
+} ut_time_t;
+
 
 //////////////////////////////////////////////////////////////////////////
 // Global Variables
@@ -87,6 +148,9 @@ volatile void* unittrace_array[UNITTRACE_LIST_SIZE];
 // amount of traced events
 ut_cnt_t unittrace_count;
 
+// timing of all labels, in order of their first 'UT_TIME_BEGIN(label)'
+ut_time_t unittrace_time[UNITTRACE_TIME_SIZE];
+
 
 //////////////////////////////////////////////////////////////////////////
 // Function Declarations
@@ -104,6 +168,20 @@ static inline void ut_assert(uint8_t cond) __attribute__((always_inline));
 // AVR8 MCUs)
 void ut_assert_manual(void* addr, uint8_t cond);
 
+// returns the table entry of 'label', NULL if it doesn't exist. If 'add' is !0, the label is added
+// if it doesn't exist yet (and there is space left). Labels are compared by content, not address.
+ut_time_t* ut_time_get(const char* label, uint8_t add);
+
+// adds the region ending at the counter value 'end' to the timing of 'label'
+void ut_time_add(const char* label, ut_cycles_t end);
+
+// returns !0 if the fastest region of 'label' took at most 'max' cycles. Returns 0 if 'label' was
+// never timed, so a typo can't pass unnoticed.
+uint8_t ut_time_check(const char* label, uint32_t max);
+
+// clears the timing of all labels
+void ut_time_reset(void);
+
 
 //////////////////////////////////////////////////////////////////////////
 // Macros
@@ -117,6 +195,23 @@ void ut_assert_manual(void* addr, uint8_t cond);
 // easier, so support for the equivalent inline function has been removed.
 #define UT_BREAK()			asm("nop")
 
+// starts a timed region. 'label' is a string, all regions with the same label are accumulated.
+// Only the counter is read within the region, so the overhead is as small as possible.
+#define UT_TIME_BEGIN(label)											\
+do{																		\
+	ut_time_t* _ut_t = ut_time_get(label, 1);							\
+	if (_ut_t != NULL)													\
+		_ut_t->start = UT_CYCLES();										\
+}while(0)
+
+// ends a timed region and updates min/avg/max of 'label'
+#define UT_TIME_END(label)		ut_time_add(label, UT_CYCLES())
+
+// fails (like 'UT_ASSERT(cond)') if even the fastest region of 'label' took longer than 'max'
+// cycles. Interrupts and preemption only make single regions slower, so a budget close to the
+// real cost holds as long as a few regions run undisturbed. The counter read adds a few cycles.
+#define UT_ASSERT_CYCLES(label, max)	UT_ASSERT(ut_time_check(label, max))
+
 
 //////////////////////////////////////////////////////////////////////////
 // Inline functions
@@ -21,6 +21,16 @@ int main(void)
 	UT_BREAK();
 	UT_ASSERT(5 == 7);	// fails and code address gets stored in array
 	UT_BREAK();
+	
+	// measure cycles; min/avg/max are stored in 'unittrace_time'
+	for (volatile uint8_t cnt=0; cnt < 10; cnt++)
+	{
+		UT_TIME_BEGIN("loop");
+		UT_BREAK();
+		UT_TIME_END("loop");
+	}
+	UT_ASSERT_CYCLES("loop", 1000);	// passes
+	UT_BREAK();
 
 	// Access generated data
 	// You can access the data either with a debugger by watching the two global variables or use